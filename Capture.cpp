@@ -0,0 +1,151 @@
+#include "Capture.h"
+#include <Arduino.h> // Arduino code environment
+#include "SystemUtil.h" // For crc16Update
+
+enum class CaptureState : uint8_t {
+  Idle,
+  Recording, // The motor is running
+  Tail, // The motor has stopped; a few more samples show the door settling
+  Sending
+};
+
+const static uint16_t headerSize = 13;
+// Samples taken after the motor stops
+const static uint16_t tailSamples = CAPTURE_SIZE / 4;
+const static uint16_t motorBit = 0x8000, openingBit = 0x4000;
+
+static uint16_t samples[CAPTURE_ENABLED ? CAPTURE_SIZE : 1];
+static CaptureState state = CaptureState::Idle;
+static uint8_t door, pin, duty;
+static bool isMotorOn, isOpening, isJam;
+// # of samples taken since the motor started, and left to take after it stopped
+static uint16_t sampleCount, tailLeft;
+static unsigned long lastSample_us;
+// Sending: the header, the next byte to send, and the CRC so far
+static uint8_t header[headerSize];
+static uint16_t sendIndex, sendCrc;
+
+// The samples kept: all of them from the start, or the latest CAPTURE_SIZE (in a ring) for a jam.
+static uint16_t keptCount() {
+  return min(sampleCount, (uint16_t)CAPTURE_SIZE);
+}
+
+static void startSending() {
+  uint16_t first = sampleCount - keptCount();
+  uint8_t h[headerSize] = {
+    'C', 'A', 'P', 1, door, (uint8_t)(isJam ? 1 : 0),
+    CAPTURE_INTERVAL_US & 0xFF, CAPTURE_INTERVAL_US >> 8, duty,
+    (uint8_t)(keptCount() & 0xFF), (uint8_t)(keptCount() >> 8), (uint8_t)(first & 0xFF), (uint8_t)(first >> 8)
+  };
+  memcpy(header, h, headerSize);
+  sendIndex = 0;
+  sendCrc = 0xFFFF;
+  state = CaptureState::Sending;
+}
+
+// Ends the capture: sends it, unless only jams are wanted and there wasn't one.
+static void finish() {
+  if (CAPTURE_TRIGGER == 0 || isJam) {
+    startSending();
+  }
+  else {
+    state = CaptureState::Idle;
+  }
+}
+
+// Byte i of the block, not counting the CRC.
+static uint8_t blockByte(uint16_t i) {
+  if (i < headerSize) {
+    return header[i];
+  }
+  i -= headerSize;
+  uint16_t first = sampleCount - keptCount();
+  uint16_t sample = samples[(first + i / 2) % CAPTURE_SIZE];
+  return i % 2 == 0 ? sample & 0xFF : sample >> 8;
+}
+
+static void takeSample() {
+  uint16_t sample = analogRead(pin) & 0x3FF;
+  if (isMotorOn) sample |= motorBit;
+  if (isOpening) sample |= openingBit;
+  samples[sampleCount % CAPTURE_SIZE] = sample;
+  sampleCount++;
+  if (state == CaptureState::Tail && --tailLeft == 0) {
+    finish();
+  }
+  else if ((CAPTURE_TRIGGER == 0 && sampleCount >= CAPTURE_SIZE) || sampleCount == 0xFFFF) {
+    finish(); // Buffer is full (or the count is)
+  }
+}
+
+static void Capture::Init() {
+  if (!CAPTURE_ENABLED) return;
+  Serial.begin(9600);
+  state = CaptureState::Idle;
+  EventBus::subscribe(EventType::JamDetected, Capture::HandleEvent);
+}
+
+static void Capture::motor(uint8_t doorIndex, uint8_t photoresistorPin, bool isOpeningDirection, uint8_t motorDuty) {
+  if (state == CaptureState::Idle && motorDuty > 0) {
+    // A move started: begin a new capture
+    door = doorIndex;
+    pin = photoresistorPin;
+    duty = motorDuty;
+    isJam = false;
+    sampleCount = 0;
+    lastSample_us = micros() - CAPTURE_INTERVAL_US;
+    state = CaptureState::Recording;
+  }
+  if ((state != CaptureState::Recording && state != CaptureState::Tail) || doorIndex != door) {
+    return; // Only one door is captured at a time
+  }
+  isMotorOn = motorDuty > 0;
+  isOpening = isOpeningDirection;
+  if (isMotorOn) {
+    state = CaptureState::Recording;
+  }
+  else if (state == CaptureState::Recording) {
+    state = CaptureState::Tail;
+    tailLeft = tailSamples;
+  }
+}
+
+static void Capture::Poll() {
+  if (!CAPTURE_ENABLED) return;
+  if (state == CaptureState::Recording || state == CaptureState::Tail) {
+    unsigned long now = micros();
+    if (now - lastSample_us >= CAPTURE_INTERVAL_US) {
+      // Keep to the fixed rate; a late sample doesn't shift the ones after it
+      lastSample_us += CAPTURE_INTERVAL_US;
+      if (now - lastSample_us >= CAPTURE_INTERVAL_US) {
+        lastSample_us = now;
+      }
+      takeSample();
+    }
+  }
+  if (state == CaptureState::Sending) {
+    // Only what fits in Serial's buffer, so this never waits
+    uint16_t length = headerSize + keptCount() * 2;
+    for (int n = Serial.availableForWrite(); n > 0 && state == CaptureState::Sending; n--) {
+      uint8_t b;
+      if (sendIndex < length) {
+        b = blockByte(sendIndex);
+        sendCrc = crc16Update(sendCrc, b);
+      }
+      else {
+        b = sendIndex == length ? sendCrc & 0xFF : sendCrc >> 8;
+      }
+      Serial.write(b);
+      if (++sendIndex == length + 2) {
+        state = CaptureState::Idle;
+      }
+    }
+  }
+}
+
+static void Capture::HandleEvent(Event e) {
+  if (e.type == EventType::JamDetected && e.arg == door
+    && (state == CaptureState::Recording || state == CaptureState::Tail)) {
+    isJam = true;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <Arduino.h> // Arduino code environment
+#include "EventBus.h"
+
+// Compile-time switch for waveform capture (1 = on, 0 = off). When off, capture points compile to
+// nothing and the buffer takes no RAM. Can also be set with -D, e.g. -DCAPTURE_ENABLED=1.
+#ifndef CAPTURE_ENABLED
+#define CAPTURE_ENABLED 0
+#endif
+// # of samples kept (2 bytes each).
+#ifndef CAPTURE_SIZE
+#define CAPTURE_SIZE 256
+#endif
+// Time between samples (us, up to 65535). 10000 = 100 Hz, so the default 256 samples cover 2.56 s:
+// a whole move at the default door time. Lower it to look closer at part of a move.
+#ifndef CAPTURE_INTERVAL_US
+#define CAPTURE_INTERVAL_US 10000
+#endif
+// What starts a capture:
+// 0 = each door move. The first CAPTURE_SIZE samples from when the motor starts are sent.
+// 1 = a jam. Every move is recorded, but only sent if it ends in a jam, with the last samples
+//     before the motor stopped (and a few after).
+#ifndef CAPTURE_TRIGGER
+#define CAPTURE_TRIGGER 0
+#endif
+
+// Records a door's photoresistor and motor at a fixed rate while it moves, then sends the samples
+// over Serial as one binary block, a few bytes per loop() so nothing waits on Serial.
+// tools/capture/capture.py reads the blocks and exports or plots them.
+//
+// Block format (little-endian):
+//   "CAP" 1 (version), door, flags (bit 0 = move ended in a jam), interval (us, 2 bytes),
+//   duty (the motor's duty when running), # of samples (2 bytes), # of the first sample since the
+//   motor started (2 bytes), the samples (2 bytes each), CRC-16/CCITT of everything before it (2 bytes).
+// Each sample: bits 0 - 9 = photoresistor reading, bit 14 = opening, bit 15 = motor running.
+class Capture {
+  public:
+    static void Init();
+    // A door's motor was started (duty > 0) or stopped (duty = 0).
+    static void motor(uint8_t door, uint8_t photoresistorPin, bool isOpening, uint8_t duty);
+    // Takes a sample when one is due, and sends a finished capture. To be called once per loop().
+    static void Poll();
+    // Marks the capture as ending in a jam. Subscribed by Init().
+    static void HandleEvent(Event e);
+};
+
+// Capture points. Only compiled in when CAPTURE_ENABLED is 1, e.g.
+// CAPTURE_MOTOR(doorIndex, photoresistor, doorDirectionIsOpen, workDuty);
+#define CAPTURE_MOTOR(door, pin, isOpening, duty) do { if (CAPTURE_ENABLED) Capture::motor(door, pin, isOpening, duty); } while (0)
+
+#endif
\ No newline at end of file
@@ -18,6 +18,11 @@ static void Debug::print(const char * msg) {
   Serial.print(msg);
 }
 
+static void Debug::print(const __FlashStringHelper* msg) {
+  if (!isInit) return;
+  Serial.print(msg);
+}
+
 static void Debug::println(String msg) {
   if (!isInit) return;
   Serial.println(msg);
@@ -28,6 +33,11 @@ static void Debug::println(const char * msg) {
   Serial.println(msg);
 }
 
+static void Debug::println(const __FlashStringHelper* msg) {
+  if (!isInit) return;
+  Serial.println(msg);
+}
+
 static bool Debug::isInputAvailable() {
   if (!isInit) return false;
   return Serial.available();
@@ -3,13 +3,56 @@
 
 #include <Arduino.h>
 
+// Compile-time debug switches (1 = on, 0 = off). DEBUG_ENABLED sets the default for every module.
+// Trace points in a module that is off compile to nothing, including building their message,
+// so a release build pays nothing for them. Can also be set with -D, e.g. -DDEBUG_DOOR=0.
+#ifndef DEBUG_ENABLED
+#define DEBUG_ENABLED 0
+#endif
+#ifndef DEBUG_MAIN
+#define DEBUG_MAIN DEBUG_ENABLED
+#endif
+#ifndef DEBUG_DOOR
+#define DEBUG_DOOR DEBUG_ENABLED
+#endif
+#ifndef DEBUG_TIME
+#define DEBUG_TIME DEBUG_ENABLED
+#endif
+#ifndef DEBUG_UI
+#define DEBUG_UI DEBUG_ENABLED
+#endif
+
+// The modules that have their own debug switch.
+enum class DebugModule : uint8_t {
+  Main, // The .ino
+  Door, // DoorMgmt
+  Time, // TimeMgmt and Schedule
+  Ui    // SystemUI
+};
+
+// True if trace points for module m are compiled in.
+constexpr bool isDebugOn(DebugModule m) {
+  return m == DebugModule::Main ? DEBUG_MAIN
+    : m == DebugModule::Door ? DEBUG_DOOR
+    : m == DebugModule::Time ? DEBUG_TIME
+    : DEBUG_UI;
+}
+
+// Trace points. msg is only evaluated if the module's switch is on, e.g.
+// DEBUG_PRINTLN(Door, "Door: " + String(read));
+// A fixed message can be kept in flash: DEBUG_PRINTLN(Door, F("Stopping door."));
+#define DEBUG_PRINT(module, msg) do { if (isDebugOn(DebugModule::module)) Debug::print(msg); } while (0)
+#define DEBUG_PRINTLN(module, msg) do { if (isDebugOn(DebugModule::module)) Debug::println(msg); } while (0)
+
 class Debug {
   public:
     static void Init();
     static void print(String msg);
     static void print(const char msg[]);
+    static void print(const __FlashStringHelper* msg);
     static void println(String msg);
     static void println(const char msg[]);
+    static void println(const __FlashStringHelper* msg);
     static bool isInputAvailable();
     static int getIntInput();
 };
@@ -1,226 +1,541 @@
 #include "DoorMgmt.h"
 #include <Arduino.h>
 #include "Debug.h"
+#include "EventBus.h"
 #include "SystemUI.h"
+#include "Trace.h"
+#include "FeedQueue.h"
+#include "Capture.h"
+#include "Tunables.h"
+#include "Timers.h"
 
-// Pin value on board
-static uint8_t direction, pwm, brake, photoresistor;
+// The motor's work duty is Tunables WorkDuty, and the time (ms) a door takes to move from start to
+// finish is DoorTime.
+// The time (ms) for closing the door at startup (when its position is unknown).
+const static unsigned long homeTime_ms = 1000;
+// How long (ms) the door is moved when forced (e.g. retrying a jam on OK), and how long it stays open
+// while dispensing.
+const static unsigned long forceTime_ms = 1000, openTime_ms = 1000;
 
-// The motor's work duty
-const static int workDuty = 250;
-// Multiply this value by intervalDoorCheck in main to get 
-// # ms time a door moves in a direction start to finish.
-const static int doorTime_ms = 25;
+// Motor current (ADC counts, the shield gives ~1.65 V/A, so ~340 counts/A) above which the motor is
+// stalled is Tunables StallCurrent (500 by default).
+// # of samples in a row over the stall current before the door is stopped, so noise doesn't trip it.
+const static uint8_t stallSamples = 5;
+// The motor draws a surge of current when starting, so the first ms of each move aren't checked.
+const static uint8_t inrush_ms = 50;
 
-const static String jamErrorMsg = String("[Error]\nJam detected.\nRemove jam, then\npress OK to resume.");
-// State variables
-static bool doorIsOpen, doorIsMoving, doorDirectionIsOpen, isDoingFoodDispensal, isOkPressed, isDoorJammed;
-static int doorMovingDuration;
+// Automatic jam retries: how many, and the wait (s) before the first, are Tunables JamRetries and JamRetryDelay.
+// Before each retry the door backs off for this long (ms), to free what's caught.
+const static unsigned long reverseTime_ms = 300;
+// The duty of each retry in turn: full power first, then gentler pushes, which free a wedged piece
+// more often than pushing it in harder.
+const static int retryDuty[3] = {255, 180, 120};
+// The wait between retries stops doubling after this many
+const static uint8_t maxBackoffSteps = 6;
+static JamStats jamStats;
 
-// Sets door moving duration to ms. Also sets doorIsMoving = true
-static void DoorMgmt::setDoorDuration(int ms) { 
-  doorMovingDuration = ms;
+// # of readings of a position needed before its jam threshold is learned rather than fixed
+const static uint8_t minLightSamples = 4;
+// # of readings of the closed door taken once it has homed at boot
+const static uint8_t calibrationSamples = 8;
+// Readings vary by at least this much (ADC counts), even when the stats say less
+const static float minLightSpread = 1.5;
+
+// Every door that has been initialized, by index. Used to route events to the right door.
+const static uint8_t maxDoors = 2;
+static DoorMgmt* doorList[maxDoors];
+static uint8_t doorListCount = 0;
+
+DoorMgmt::DoorMgmt() {
+  doorIndex = 0;
+  scheduleId = 0;
+  timer = Timers::none;
+  doorIsOpen = false;
+  doorIsMoving = false;
+  doorDirectionIsOpen = false;
+  isDoingFoodDispensal = false;
+  isDoorJammed = false;
+  isOkPressed = false;
+  isHoming = false;
+  isRecovering = false;
+  isReversing = false;
+  isRetrying = false;
+  retryCount = 0;
+  jamStart_ms = 0;
+  currentSense = noSensePin;
+  moveStart_ms = 0;
+  stallCount = 0;
+  peakCurrent = 0;
+  stallPeakCurrent = 0;
+  light[0].clear();
+  light[1].clear();
+  lastLight = 0;
+  isLightDrifting = false;
+}
+
+// Arms the door's timer to end the move in ms (replacing any timeout pending), then starts the motor at
+// duty. Also sets doorIsMoving = true. With no timer free, nothing would stop the motor, so the move is
+// refused instead, and reported like a jam: pressing OK (or the next automatic retry) tries it again.
+void DoorMgmt::startMove(unsigned long ms, int duty) {
+  Timers::cancel(&timer);
+  timer = Timers::start(ms, DoorMgmt::onMoveTimer, doorIndex);
+  if (timer == Timers::none) {
+    DEBUG_PRINTLN(Door, F("No timer free, move refused."));
+    isHoming = false;
+    isReversing = false;
+    onJam();
+    return;
+  }
   doorIsMoving = true;
+  // Start watching the motor current for this move
+  moveStart_ms = millis();
+  stallCount = 0;
+  peakCurrent = 0;
+  startMotor(duty);
 }
 // Sets door direction and updates direction pin accordingly.
-static void DoorMgmt::setDoorDirection(bool isOpenDirection) {
+void DoorMgmt::setDoorDirection(bool isOpenDirection) {
   doorDirectionIsOpen = isOpenDirection;
   // Sets direction pin. HIGH/LOW could be swapped to reverse the physical direction.
   digitalWrite(direction, (doorDirectionIsOpen ? HIGH : LOW));
 }
 
 // Returns true = door is open, false = door is closed
-static bool DoorMgmt::isDoorOpen() {
+bool DoorMgmt::isDoorOpen() {
   return doorIsOpen;
 }
 // Returns true = door is moving, false = door is closed
-static bool DoorMgmt::isDoorMoving() {
+bool DoorMgmt::isDoorMoving() {
   return doorIsMoving;
 }
 
+// Returns true = door is jammed (from the jam until a retry gets it moving freely), false = not jammed
+bool DoorMgmt::isJammed() {
+  return isRecovering;
+}
+
 // Returns true = currently dispensing food, false = idle
-static bool DoorMgmt::isDispensingFood() {
-  if (doorMovingDuration > 0 && !isDoingFoodDispensal) {
-    Debug::println("WARN: Dispensal false, but duration = " + String(doorMovingDuration));
+bool DoorMgmt::isDispensingFood() {
+  if (doorIsMoving && !isDoingFoodDispensal && !isHoming) {
+    DEBUG_PRINTLN(Door, F("WARN: Dispensal false, but door is moving"));
   }
   return isDoingFoodDispensal;
 }
 
+// Runs the motor at duty in the direction last set, with the brake off.
+void DoorMgmt::startMotor(int duty) {
+  analogWrite(pwm, duty);
+  digitalWrite(brake, LOW);
+  TRACE(Motor, doorIndex | (doorDirectionIsOpen ? 0x80 : 0), duty);
+  CAPTURE_MOTOR(doorIndex, photoresistor, doorDirectionIsOpen, duty);
+}
+
 // Force stops the door.
-static void DoorMgmt::forceStopDoor() {
-  Debug::println("Stopping door.");
+void DoorMgmt::forceStopDoor() {
+  DEBUG_PRINTLN(Door, F("Stopping door."));
+  TRACE(Motor, doorIndex, 0);
+  CAPTURE_MOTOR(doorIndex, photoresistor, doorDirectionIsOpen, 0);
   // Set motor's work load to 0
   analogWrite(pwm, 0);
   // Enable brakes.
   digitalWrite(brake, HIGH);
-  // Update doorMoving.
+  // Update doorMoving, and drop the end of the move (a stopped door's pause or retry is left to run).
+  if (doorIsMoving) {
+    Timers::cancel(&timer);
+  }
   doorIsMoving = false;
 }
 
 // Force opens the door, after checking if the door is closed and not moving. 
-// Override skips the check.
-static void DoorMgmt::forceOpenDoor(bool override = false) {
+// Override skips the check, and only runs the motor for forceTime_ms.
+void DoorMgmt::forceOpenDoor(bool override) {
   if (override) {
-    Debug::println("Opening door.");
-    DoorMgmt::setDoorDirection(true);
-    analogWrite(pwm, workDuty);
-    digitalWrite(brake, LOW);
-    delay(1000);
-    DoorMgmt::forceStopDoor();
+    DEBUG_PRINTLN(Door, F("Opening door."));
+    setDoorDirection(true);
+    startMove(forceTime_ms, Tunables::get(TunableId::WorkDuty));
     return;
   }
 
   // if the door is closed and not moving,
-  if (!DoorMgmt::isDoorOpen() && !DoorMgmt::isDoorMoving()) {
+  if (!isDoorOpen() && !isDoorMoving()) {
     // then start the "open door" routine
-    Debug::println("Opening door.");
-    DoorMgmt::setDoorDirection(true);
-    DoorMgmt::setDoorDuration(doorTime_ms);
-    analogWrite(pwm, workDuty);
-    digitalWrite(brake, LOW);
+    DEBUG_PRINTLN(Door, F("Opening door."));
+    setDoorDirection(true);
+    startMove(Tunables::get(TunableId::DoorTime), Tunables::get(TunableId::WorkDuty));
   }
 }
 
+// Closes the door without checking its state, e.g. at startup when its position is unknown.
+// The door's timer stops it once it has had time to close.
+void DoorMgmt::homeDoor() {
+  DEBUG_PRINTLN(Door, F("Homing door."));
+  isHoming = true;
+  setDoorDirection(false);
+  startMove(homeTime_ms, Tunables::get(TunableId::WorkDuty));
+}
+
 // Force closes the door, after checking if the door is open and not moving. 
-// Override skips the check.
-static void DoorMgmt::forceCloseDoor(bool override = false) {
+// Override skips the check, and only runs the motor for forceTime_ms.
+void DoorMgmt::forceCloseDoor(bool override) {
   // Override ignores whether it is feeding time or the door is open or not.
   if (override) {
-    Debug::println("Closing door.");
-    DoorMgmt::setDoorDirection(false);
-    analogWrite(pwm, workDuty);
-    digitalWrite(brake, LOW);
-    delay(1000);
-    DoorMgmt::forceStopDoor();
+    DEBUG_PRINTLN(Door, F("Closing door."));
+    setDoorDirection(false);
+    startMove(forceTime_ms, Tunables::get(TunableId::WorkDuty));
     return;
   }
   
   // if the door is open and not moving,
-  if (DoorMgmt::isDoorOpen() && !DoorMgmt::isDoorMoving()) {
-    Debug::println("Closing door.");
+  if (isDoorOpen() && !isDoorMoving()) {
+    DEBUG_PRINTLN(Door, F("Closing door."));
     // then start the "close door" routine
-    DoorMgmt::setDoorDirection(false);
-    DoorMgmt::setDoorDuration(doorTime_ms);
-    analogWrite(pwm, workDuty);
-    digitalWrite(brake, LOW);
+    setDoorDirection(false);
+    startMove(Tunables::get(TunableId::DoorTime), Tunables::get(TunableId::WorkDuty));
   }
 }
 
 // To be called in system monitoring to update door process
-static void DoorMgmt::ClockTick() {
-  if (isDoorJammed) {
-    // When the user presses OK,
-    if (isOkPressed) {
-      Debug::println("Attempting door again");
-      isOkPressed = false;
-      SystemUI::SetText("Resuming...", -1);
-      if (doorDirectionIsOpen) {
-        DoorMgmt::forceOpenDoor(true);
-      }
-      else {
-        DoorMgmt::forceCloseDoor(true);
-      }
-      // detect jam
-      if (DoorMgmt::detectJam() == false) {
-        // if no jam, update ui text (the isDoorJammed is updated in detectJam)
-        SystemUI::SetText("Dispensing food.", 2);
-        goto resume_food; // Jam error is resolved; go to resume food.
-      }
-      else {
-        SystemUI::SetText(jamErrorMsg, -1);
-      }
+void DoorMgmt::ClockTick() {
+  FeedJob job;
+  // Once the door is free, start the next feeding queued on its schedule.
+  if (!isDoingFoodDispensal && !doorIsMoving && !isDoorJammed && FeedQueue::pop(scheduleId, &job)) {
+    DEBUG_PRINTLN(Door, "Feeding due at " + String(job.due) + " started.");
+    dispenseFood();
+  }
+  // When the user presses OK on a jam, try the move again (onMoveDone checks it as usual)
+  if (isDoorJammed && isOkPressed) {
+    DEBUG_PRINTLN(Door, F("Attempting door again"));
+    isOkPressed = false;
+    isDoorJammed = false;
+    if (doorDirectionIsOpen) {
+      forceOpenDoor(true);
     }
+    else {
+      forceCloseDoor(true);
+    }
+  }
+}
+
+// The door's move has run its time.
+void DoorMgmt::onMoveDone() {
+  // if door is done backing off, retry the move
+  if (isReversing) {
+    retryMove();
     return;
   }
-  if (doorIsMoving) {
-    doorMovingDuration--;
-    Debug::println(String(doorMovingDuration) + " dur");
-  }
-  // if door is done moving,
-  if (doorMovingDuration <= 0 && doorIsMoving) {
-    doorIsOpen = doorDirectionIsOpen; // doorIsOpen is updated
-    // If there is a jam,
-    if (DoorMgmt::detectJam()) {
-      // Alert to the user. Message is cleared when jam is resolved.
-      SystemUI::SetText(jamErrorMsg, -1);
-      DoorMgmt::forceStopDoor();
-      return;
-    }
-    resume_food:
-    // If we are on the food routine, (there is no jam)
-    if (isDoingFoodDispensal) {
-      // and the door is open,
-      if (doorIsOpen) {
-        // then stop and close the door
-        DoorMgmt::forceStopDoor();
-        delay(1000);
-        DoorMgmt::forceCloseDoor();
-      }
-      else {
-        // This means door is closed and we are done with food routine.
-        DoorMgmt::forceStopDoor();
-        isDoingFoodDispensal = false;
+  forceStopDoor();
+  onStopped();
+}
+
+// The door has stopped at the end of its move (its time ran out, or it stalled against its stop):
+// checks where it is.
+void DoorMgmt::onStopped() {
+  // if door is done homing, it is closed (no jam check, as it may have been closed already)
+  if (isHoming) {
+    isHoming = false;
+    doorIsOpen = false;
+    calibrateClosed();
+    // A feeding that came due while homing waits in FeedQueue until the next tick
+    return;
+  }
+  doorIsOpen = doorDirectionIsOpen; // doorIsOpen is updated
+  bool isJam = detectJam();
+  // If there is a jam,
+  if (isJam) {
+    // Alert to the user. Message is cleared when jam is resolved.
+    onJam();
+    return;
+  }
+  // The door is where it should be, so its reading is one to learn the thresholds from
+  learnLight(doorIsOpen, lastLight);
+  if (isRecovering) {
+    onJamCleared();
+  }
+  if (doorIsOpen) {
+    EventBus::post(EventType::DoorOpened, doorIndex);
+  }
+  // If we are on the food routine, (there is no jam)
+  if (isDoingFoodDispensal) {
+    // and the door is open,
+    if (doorIsOpen) {
+      // then close the door once the food has had time to fall (or right away, with no timer free)
+      timer = Timers::start(openTime_ms, DoorMgmt::onPauseTimer, doorIndex);
+      if (timer == Timers::none) {
+        forceCloseDoor();
       }
     }
+    else {
+      // This means door is closed and we are done with food routine.
+      isDoingFoodDispensal = false;
+      EventBus::post(EventType::DispenseDone, doorIndex);
+    }
   }
 }
 
-static void DoorMgmt::Init(uint8_t directionPin, uint8_t pwmPin, uint8_t brakePin, uint8_t photoresistorPin) {
+// Each timer callback first lets go of the timer's id, which has gone off (see TimerId).
+static void DoorMgmt::onMoveTimer(uint8_t door) {
+  doorList[door]->timer = Timers::none;
+  doorList[door]->onMoveDone();
+}
+static void DoorMgmt::onPauseTimer(uint8_t door) {
+  doorList[door]->timer = Timers::none;
+  doorList[door]->forceCloseDoor();
+}
+// Retries by itself once it's time to (unless OK got to it first)
+static void DoorMgmt::onRetryTimer(uint8_t door) {
+  DoorMgmt* d = doorList[door];
+  d->timer = Timers::none;
+  if (d->isDoorJammed && d->retryCount < Tunables::get(TunableId::JamRetries)) {
+    d->startRetry();
+  }
+}
+
+void DoorMgmt::Init(uint8_t index, uint8_t directionPin, uint8_t pwmPin, uint8_t brakePin, uint8_t photoresistorPin,
+  uint8_t currentSensePin) {
+  doorIndex = index;
+  if (index < maxDoors) {
+    doorList[index] = this;
+    if (doorListCount == 0) {
+      // The first door subscribes to the events every door handles.
+      EventBus::subscribe(EventType::ButtonPressed, DoorMgmt::HandleEvent);
+    }
+    doorListCount = max(doorListCount, index + 1);
+  }
   // Setting pin values
   direction = directionPin;
   pwm = pwmPin;
   brake = brakePin;
   photoresistor = photoresistorPin;
+  currentSense = currentSensePin;
 
   // Setting other status variables
-  doorMovingDuration = 0;
+  timer = Timers::none;
   doorIsOpen = false;
   doorIsMoving = false;
   isDoingFoodDispensal = false;
   isDoorJammed = false;
   isOkPressed = false;
-  DoorMgmt::setDoorDirection(false); // default in the closing direction
+  isRecovering = false;
+  isReversing = false;
+  isRetrying = false;
+  retryCount = 0;
+  setDoorDirection(false); // default in the closing direction
+}
+
+// Sets the schedule this door dispenses food on.
+void DoorMgmt::bindSchedule(uint8_t sched) {
+  scheduleId = sched;
+}
+uint8_t DoorMgmt::getScheduleId() {
+  return scheduleId;
+}
+
+// Routes events to the doors:
+// (Feedings aren't events here: ClockTick takes them from FeedQueue once the door is free.)
+// OK presses are passed to doors that are dispensing (e.g. to resume after a jam).
+static void DoorMgmt::HandleEvent(Event e) {
+  for (uint8_t i = 0; i < doorListCount; i++) {
+    switch (e.type) {
+      case EventType::ButtonPressed:
+        if ((UiButton)e.arg == UiButton::OK && doorList[i]->isDispensingFood()) {
+          doorList[i]->okPressedHandler();
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// Catches a jam while the door is moving, instead of after the move (by detectJam()).
+// A stall ends the move early; the door has either reached its stop or hit something.
+void DoorMgmt::SenseTick() {
+  if (currentSense == noSensePin || !doorIsMoving || millis() - moveStart_ms < inrush_ms) {
+    return;
+  }
+  uint16_t current = analogRead(currentSense);
+  peakCurrent = max(peakCurrent, current);
+  if (current < Tunables::get(TunableId::StallCurrent)) {
+    stallCount = 0;
+    return;
+  }
+  if (++stallCount < stallSamples) {
+    return;
+  }
+  // The motor is stalled: stop pushing right away.
+  TRACE(Adc, doorIndex | 0x80, current);
+  stallPeakCurrent = peakCurrent;
+  DEBUG_PRINTLN(Door, "Stall, peak current: " + String(peakCurrent));
+  forceStopDoor();
+  // Backed into something while backing off: go straight on to the retry.
+  if (isReversing) {
+    retryMove();
+    return;
+  }
+  // The door has reached its stop, or something is in the way. The light reading tells which, as at
+  // the end of any move: a door stopped short of where it should be is a jam, which pressing OK (or
+  // the next automatic retry) retries. How far into the move the stall came doesn't, as a door that
+  // started part way (e.g. after a forced move) reaches its stop early.
+  onStopped();
+}
+
+uint16_t DoorMgmt::getStallPeakCurrent() {
+  return stallPeakCurrent;
+}
+
+// Starts an automatic retry of the jammed move: the door backs off a little first.
+void DoorMgmt::startRetry() {
+  retryCount++;
+  jamStats.retries++;
+  isRetrying = true;
+  isReversing = true;
+  isDoorJammed = false;
+  DEBUG_PRINTLN(Door, "Retry " + String(retryCount) + " of " + String(Tunables::get(TunableId::JamRetries)));
+  setDoorDirection(!doorDirectionIsOpen);
+  startMove(reverseTime_ms, retryDuty[(retryCount - 1) % 3]);
+}
+// Once the door has backed off, retries the jammed move (in full, so onMoveDone checks it as usual).
+void DoorMgmt::retryMove() {
+  isReversing = false;
+  setDoorDirection(!doorDirectionIsOpen);
+  startMove(Tunables::get(TunableId::DoorTime), retryDuty[(retryCount - 1) % 3]);
+}
+
+// A move ended in a jam: lets the UI know, and schedules the next automatic retry, which waits twice as
+// long as the last. Once the retries run out, it's up to the operator (OK).
+void DoorMgmt::onJam() {
+  isDoorJammed = true;
+  if (!isRecovering) {
+    isRecovering = true;
+    retryCount = 0;
+    jamStart_ms = millis();
+    jamStats.jams++;
+  }
+  if (isRetrying && retryCount >= Tunables::get(TunableId::JamRetries)) {
+    jamStats.escalated++;
+    DEBUG_PRINTLN(Door, F("Retries used up, waiting on OK."));
+  }
+  isRetrying = false;
+  if (retryCount < Tunables::get(TunableId::JamRetries)) {
+    timer = Timers::start((unsigned long)Tunables::get(TunableId::JamRetryDelay) * 1000 << min(retryCount, maxBackoffSteps),
+      DoorMgmt::onRetryTimer, doorIndex);
+  }
+  EventBus::post(EventType::JamDetected, doorIndex);
+}
+// The door moved freely again, after a retry (automatic or OK).
+void DoorMgmt::onJamCleared() {
+  jamStats.recovered++;
+  jamStats.recoveryTotal_s += (millis() - jamStart_ms) / 1000;
+  if (isRetrying) {
+    jamStats.autoCleared++;
+  }
+  DEBUG_PRINTLN(Door, "Jam cleared after " + String((millis() - jamStart_ms) / 1000) + " s.");
+  isRecovering = false;
+  isRetrying = false;
+  retryCount = 0;
+  EventBus::post(EventType::JamCleared, doorIndex);
+}
+
+static const JamStats& DoorMgmt::getJamStats() {
+  return jamStats;
+}
+static uint8_t DoorMgmt::getRetryCount(uint8_t door) {
+  return door < doorListCount ? doorList[door]->retryCount : 0;
+}
+
+// Adds a reading taken with the door confirmed at a position. Warns (LightDrift) once the readings of
+// the two positions are within LightSeparation standard deviations of each other (from either side),
+// e.g. as the sensor gathers dust, as from there on jams are easily missed or seen where there are none.
+void DoorMgmt::learnLight(bool isOpen, uint16_t read) {
+  light[isOpen].add(read, Tunables::get(TunableId::LightWindow));
+  if (light[0].n < minLightSamples || light[1].n < minLightSamples) {
+    return;
+  }
+  float k = Tunables::get(TunableId::LightSeparation);
+  bool isOverlapping = light[1].mean - light[0].mean
+    < k * (max(light[0].spread(), minLightSpread) + max(light[1].spread(), minLightSpread));
+  if (isOverlapping && !isLightDrifting) {
+    DEBUG_PRINTLN(Door, "Light readings overlap: closed " + String(light[0].mean) + ", open " + String(light[1].mean));
+    EventBus::post(EventType::LightDrift, doorIndex);
+  }
+  isLightDrifting = isOverlapping;
+}
+
+// Takes a few readings of the closed door once it has homed at boot, so its threshold is learned from
+// the start. A reading too bright for a closed door (e.g. homing didn't finish closing it) is left out.
+void DoorMgmt::calibrateClosed() {
+  for (uint8_t i = 0; i < calibrationSamples; i++) {
+    uint16_t read = analogRead(photoresistor);
+    TRACE(Adc, doorIndex, read);
+    if (read <= Tunables::get(TunableId::JamHigh)) {
+      learnLight(false, read);
+    }
+  }
+}
+
+const RunningStats& DoorMgmt::getLightStats(bool isOpen) {
+  return light[isOpen];
+}
+
+// Once both positions have been learned, both thresholds are the point between their mean readings
+// that is as many standard deviations from each, which leaves the most room for noise and drift either
+// way. Until then, they are Tunables JamHigh and JamLow.
+void DoorMgmt::getJamThresholds(uint16_t* high, uint16_t* low) {
+  const RunningStats& closed = light[0];
+  const RunningStats& open = light[1];
+  float h = Tunables::get(TunableId::JamHigh), l = Tunables::get(TunableId::JamLow);
+  if (closed.n >= minLightSamples && open.n >= minLightSamples) {
+    float closedSpread = max(closed.spread(), minLightSpread), openSpread = max(open.spread(), minLightSpread);
+    h = (closed.mean * openSpread + open.mean * closedSpread) / (closedSpread + openSpread);
+    l = h;
+  }
+  *high = (uint16_t)min(max(h, 0.0f), 1023.0f);
+  *low = (uint16_t)min(max(l, 0.0f), 1023.0f);
 }
 
 // Starts the food dispensal routine.
 // To be called from system management.
-static void DoorMgmt::dispenseFood() {
+void DoorMgmt::dispenseFood() {
+  EventBus::post(EventType::DispenseStarted, doorIndex);
   isDoingFoodDispensal = true;
-  DoorMgmt::forceOpenDoor(); // Start food dispensal by opening door
+  forceOpenDoor(); // Start food dispensal by opening door
   // ClockTick will forceCloseDoor at appropriate time.
 }
 
 // Returns true if jam detected, returns false otherwise.
 // Updates value of `isDoorJammed` accordingly.
-static bool DoorMgmt::detectJam() {
+bool DoorMgmt::detectJam() {
   // high value read = light = door open
   // low value read = no light = door closed
   // If door closes and light is still high, there is a jam.
   // If door opens and light is still low, there is a jam.
 
-  uint8_t high_reading = 40; // Adjust values as needed.
-  uint8_t low_reading = 20;
+  // Learned from this door's readings (see getJamThresholds())
+  uint16_t high_reading, low_reading;
+  getJamThresholds(&high_reading, &low_reading);
 
   int read = analogRead(photoresistor);
+  TRACE(Adc, doorIndex, read);
+  lastLight = read;
   // If door should be open, but sensor reads door closed (or vice versa),
   if (doorIsOpen && read < low_reading) {
-    Debug::println("Door: " + String(read) + " < " + String(low_reading));
+    DEBUG_PRINTLN(Door, "Door: " + String(read) + " < " + String(low_reading));
     isDoorJammed = true;
     return true; // Jam
   }
   
   if (!doorIsOpen && read > high_reading) {
-    Debug::println("Door: " + String(read) + " > " + String(high_reading));
+    DEBUG_PRINTLN(Door, "Door: " + String(read) + " > " + String(high_reading));
     isDoorJammed = true;
     return true; // Jam
   }
 
-  Debug::println("Door: " + String(read));
+  DEBUG_PRINTLN(Door, "Door: " + String(read));
   isDoorJammed = false;
   return false; // No jam (expected)
 }
 
-static void DoorMgmt::okPressedHandler() {
+void DoorMgmt::okPressedHandler() {
   isOkPressed = true;
-  Debug::println("Okpressed = " + String(isOkPressed));
+  DEBUG_PRINTLN(Door, "Okpressed = " + String(isOkPressed));
 }
\ No newline at end of file
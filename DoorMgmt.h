@@ -2,23 +2,102 @@
 #define DOORMGMT_H
 
 #include "Arduino.h"
+#include "EventBus.h"
+#include "RunningStats.h"
+#include "Timers.h"
+
+// How jams have been dealt with, across all doors.
+struct JamStats {
+  // Jams detected (a failed retry doesn't count as another), automatic retries made, jams an automatic
+  // retry cleared, and jams left to the operator once the last retry failed
+  uint16_t jams, retries, autoCleared, escalated;
+  // Jams recovered from (by a retry or OK), and the total time (s) from detection until then
+  uint16_t recovered;
+  uint32_t recoveryTotal_s;
+};
+
+// One food door, driven by one channel of the motor shield.
+// Each door owns its pins, state and jam sensor, so several doors can be run at once.
 class DoorMgmt {
   private:
-    static void setDoorDuration(int ms);
-    static void setDoorDirection(bool isOperDirection);
+    // Pin value on board
+    uint8_t direction, pwm, brake, photoresistor, currentSense;
+    // The door's index (starting at 0), sent with its events.
+    uint8_t doorIndex;
+    // The id of the schedule (in TimeMgmt) this door dispenses food on.
+    uint8_t scheduleId;
+    // State variables
+    bool doorIsOpen, doorIsMoving, doorDirectionIsOpen, isDoingFoodDispensal, isOkPressed, isDoorJammed, isHoming;
+    // Jam recovery: true from a jam until the door moves freely again, true while backing off before a
+    // retry, and true while the move is an automatic retry
+    bool isRecovering, isReversing, isRetrying;
+    // # of automatic retries made for this jam, and when (ms) the jam was detected
+    uint8_t retryCount;
+    unsigned long jamStart_ms;
+    // The door's pending timeout: the end of a move, the pause while open, or the next automatic retry
+    TimerId timer;
+    // Motor current while moving (ADC counts): when the move started (ms), # of samples in a row over
+    // the stall threshold, and the highest reading of this move and of the last stall.
+    unsigned long moveStart_ms;
+    uint8_t stallCount;
+    uint16_t peakCurrent, stallPeakCurrent;
+    // Light readings (photoresistor) at confirmed positions, by position (0 = closed, 1 = open), that
+    // the jam thresholds are learned from. Also the last reading, and whether the two positions' readings
+    // have started to overlap.
+    RunningStats light[2];
+    uint16_t lastLight;
+    bool isLightDrifting;
+    void startMove(unsigned long ms, int duty);
+    void setDoorDirection(bool isOperDirection);
+    void startMotor(int duty);
+    void startRetry();
+    void retryMove();
+    void onJam();
+    void onJamCleared();
+    void learnLight(bool isOpen, uint16_t read);
+    void calibrateClosed();
+    void onMoveDone();
+    void onStopped();
+    // Timer callbacks. arg = door index
+    static void onMoveTimer(uint8_t door);
+    static void onPauseTimer(uint8_t door);
+    static void onRetryTimer(uint8_t door);
   public:
-    static void Init(uint8_t directionPin, uint8_t pwmPin, uint8_t brakePin, uint8_t photoresistorPin);
-    static void forceOpenDoor(bool override = false);
-    static void forceCloseDoor(bool override = false);
-    static void forceStopDoor();
-    static void dispenseFood();
-    static bool detectJam();
-    static bool isDoorOpen();
-    static bool isDoorMoving();
-    static bool isDispensingFood();
-    static void okPressedHandler();
-    // To be called once per ~100 ms
-    static void ClockTick();
+    // Pass as currentSensePin for a door without current sensing.
+    static const uint8_t noSensePin = 255;
+    DoorMgmt();
+    void Init(uint8_t index, uint8_t directionPin, uint8_t pwmPin, uint8_t brakePin, uint8_t photoresistorPin,
+      uint8_t currentSensePin = noSensePin);
+    void bindSchedule(uint8_t sched);
+    uint8_t getScheduleId();
+    void forceOpenDoor(bool override = false);
+    void forceCloseDoor(bool override = false);
+    void forceStopDoor();
+    void homeDoor();
+    void dispenseFood();
+    bool detectJam();
+    bool isDoorOpen();
+    bool isDoorMoving();
+    bool isJammed();
+    bool isDispensingFood();
+    void okPressedHandler();
+    // Starts queued feedings and retries on OK. To be called once per ~100 ms
+    void ClockTick();
+    // Samples the motor current, stopping the door as soon as it stalls. To be called once per ~2 ms.
+    void SenseTick();
+    // The peak motor current (ADC counts) of the last stall.
+    uint16_t getStallPeakCurrent();
+    // The light readings learned for a position (true = open).
+    const RunningStats& getLightStats(bool isOpen);
+    // The jam thresholds: a closed door reading above high, or an open door reading below low, is jammed.
+    // Learned from the door's readings, or Tunables JamHigh and JamLow until there are enough.
+    void getJamThresholds(uint16_t* high, uint16_t* low);
+    static const JamStats& getJamStats();
+    // The automatic retries made so far for a door's jam (0 once it's cleared). While it's below Tunables
+    // JamRetries, the next retry is pending; after that the jam waits on OK.
+    static uint8_t getRetryCount(uint8_t door);
+    // Subscribed to events by Init().
+    static void HandleEvent(Event e);
 };
 
 #endif
\ No newline at end of file
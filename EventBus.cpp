@@ -0,0 +1,82 @@
+#include <Arduino.h> // Arduino code environment
+#include "EventBus.h"
+
+// Queue size must be a power of 2. One slot is always left empty to tell a full queue from an empty one.
+const static uint8_t queueSize = 16;
+const static uint8_t maxSubscribers = 16;
+
+// A ring of events: posted at head, dispatched from tail.
+struct EventRing {
+  Event events[queueSize];
+  uint8_t head;
+  uint8_t tail;
+};
+
+static EventRing queue;
+static uint8_t droppedCount;
+static EventType subscriberTypes[maxSubscribers];
+static EventHandler subscriberHandlers[maxSubscribers];
+static uint8_t subscriberCount;
+
+static bool pushEvent(EventRing* ring, EventType type, uint8_t arg) {
+  uint8_t head = ring->head;
+  uint8_t next = (head + 1) & (queueSize - 1);
+  if (next == ring->tail) {
+    droppedCount++;
+    return false; // Full
+  }
+  ring->events[head].type = type;
+  ring->events[head].arg = arg;
+  ring->head = next;
+  return true;
+}
+
+static bool popEvent(EventRing* ring, Event* e) {
+  uint8_t tail = ring->tail;
+  if (tail == ring->head) {
+    return false; // Empty
+  }
+  *e = ring->events[tail];
+  ring->tail = (tail + 1) & (queueSize - 1);
+  return true;
+}
+
+static void EventBus::Init() {
+  queue.head = queue.tail = 0;
+  droppedCount = 0;
+  subscriberCount = 0;
+}
+
+static bool EventBus::post(EventType type, uint8_t arg) {
+  return pushEvent(&queue, type, arg);
+}
+
+static bool EventBus::subscribe(EventType type, EventHandler handler) {
+  if (subscriberCount >= maxSubscribers) {
+    return false;
+  }
+  subscriberTypes[subscriberCount] = type;
+  subscriberHandlers[subscriberCount] = handler;
+  subscriberCount++;
+  return true;
+}
+
+static void EventBus::Dispatch() {
+  Event e;
+  // Handlers may post more events; they are handled in this same pass, up to two queues' worth
+  // so that handlers posting to each other can't hold up loop() forever.
+  for (uint8_t n = 0; n < queueSize * 2; n++) {
+    if (!popEvent(&queue, &e)) {
+      return;
+    }
+    for (uint8_t i = 0; i < subscriberCount; i++) {
+      if (subscriberTypes[i] == e.type) {
+        subscriberHandlers[i](e);
+      }
+    }
+  }
+}
+
+static uint8_t EventBus::getDroppedCount() {
+  return droppedCount;
+}
\ No newline at end of file
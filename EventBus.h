@@ -0,0 +1,43 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <Arduino.h> // Arduino code environment
+
+// The kinds of events modules post to each other.
+enum class EventType : uint8_t {
+  FeedDue = 0, // arg = schedule id (the feeding is queued in FeedQueue)
+  DispenseStarted = 1, // arg = door index
+  DispenseDone = 2, // arg = door index
+  DoorOpened = 3, // arg = door index
+  JamDetected = 4, // arg = door index
+  JamCleared = 5, // arg = door index
+  ButtonPressed = 6, // arg = UiButton
+  TimeChanged = 7,
+  LowMemory = 8, // arg = bytes left free (up to 255)
+  LightDrift = 9 // arg = door index. The door's open and closed light readings have started to overlap.
+};
+
+struct Event {
+  EventType type;
+  uint8_t arg;
+};
+
+typedef void (*EventHandler)(Event e);
+
+// A fixed-size event queue between modules, dispatched to subscribers from loop().
+// Only main code posts. An interrupt sets a flag instead, and main code posts for it (as TimeMgmt does
+// for the RTC's square wave), so the queue needs no guarding from interrupts.
+class EventBus {
+  public:
+    static void Init();
+    // Posts from main code (including from inside a handler). Returns false if the queue is full.
+    static bool post(EventType type, uint8_t arg = 0);
+    // Calls handler for each event of type. Returns false if there is no room for another subscriber.
+    static bool subscribe(EventType type, EventHandler handler);
+    // Sends the queued events to their subscribers. To be called once per loop().
+    static void Dispatch();
+    // The # of events dropped because the queue was full.
+    static uint8_t getDroppedCount();
+};
+
+#endif
\ No newline at end of file
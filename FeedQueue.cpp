@@ -0,0 +1,97 @@
+#include <Arduino.h> // Arduino code environment
+#include "FeedQueue.h"
+#include "Debug.h"
+
+// Jobs in the order they came due. The queue is short, so removing from the middle just shifts the rest down.
+static FeedJob jobs[FeedQueue::maxJobs];
+static uint8_t jobCount;
+static uint8_t droppedCount;
+static FeedStalePolicy stalePolicy = FeedStalePolicy::Merge;
+// How long (seconds) a job may wait before the stale policy applies to it.
+static long maxAge = 3600;
+
+static void removeJob(uint8_t index) {
+  for (uint8_t i = index; i + 1 < jobCount; i++) {
+    jobs[i] = jobs[i + 1];
+  }
+  jobCount--;
+}
+
+static void FeedQueue::Init() {
+  jobCount = 0;
+  droppedCount = 0;
+}
+
+static void FeedQueue::setStalePolicy(FeedStalePolicy policy, long maxAge_s) {
+  stalePolicy = policy;
+  maxAge = maxAge_s;
+}
+
+static bool FeedQueue::push(uint8_t sched, long due) {
+  if (jobCount < maxJobs) {
+    jobs[jobCount].due = due;
+    jobs[jobCount].scheduleId = sched;
+    jobCount++;
+    DEBUG_PRINTLN(Door, "Feeding queued, depth " + String(jobCount));
+    return true;
+  }
+  // Full. When merging, the latest job on the schedule stands in for this feeding too.
+  for (int8_t i = jobCount - 1; i >= 0 && stalePolicy == FeedStalePolicy::Merge; i--) {
+    if (jobs[i].scheduleId == sched) {
+      jobs[i].due = due;
+      return false;
+    }
+  }
+  droppedCount++;
+  DEBUG_PRINTLN(Door, F("Feed queue full, feeding dropped."));
+  return false;
+}
+
+static bool FeedQueue::pop(uint8_t sched, FeedJob* job) {
+  for (uint8_t i = 0; i < jobCount; i++) {
+    if (jobs[i].scheduleId == sched) {
+      *job = jobs[i];
+      removeJob(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void FeedQueue::expire(long now) {
+  uint8_t i = 0;
+  while (i < jobCount) {
+    bool isStale = now - jobs[i].due > maxAge;
+    bool hasLater = false;
+    for (uint8_t j = i + 1; j < jobCount && !hasLater; j++) {
+      hasLater = jobs[j].scheduleId == jobs[i].scheduleId;
+    }
+    // Merging keeps the latest job on each schedule, which stands in for the stale ones before it.
+    if (isStale && (stalePolicy == FeedStalePolicy::Drop || hasLater)) {
+      if (stalePolicy == FeedStalePolicy::Drop) {
+        droppedCount++;
+      }
+      DEBUG_PRINTLN(Door, F("Stale feeding removed from queue."));
+      removeJob(i);
+    }
+    else {
+      i++;
+    }
+  }
+}
+
+static uint8_t FeedQueue::getDepth() {
+  return jobCount;
+}
+
+static uint8_t FeedQueue::getDepth(uint8_t sched) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < jobCount; i++) {
+    n += jobs[i].scheduleId == sched;
+  }
+  return n;
+}
+
+static uint8_t FeedQueue::getDroppedCount() {
+  return droppedCount;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef FEEDQUEUE_H
+#define FEEDQUEUE_H
+
+#include <Arduino.h> // Arduino code environment
+
+// What FeedQueue::expire() does with a feeding that has waited longer than the max age
+// (e.g. while its door was jammed).
+enum class FeedStalePolicy : uint8_t {
+  Merge, // Fold it into a later feeding on the same schedule, so a backlog feeds once per schedule
+  Drop,  // Drop it
+};
+
+// A feeding waiting for its door.
+struct FeedJob {
+  long due; // When the feeding came due, in # of seconds since 2000-01-01
+  uint8_t scheduleId;
+};
+
+// Feedings that came due, waiting for the door of their schedule to be free. TimeMgmt adds each
+// feeding as it comes due, and each door takes the oldest job on its schedule whenever it is idle,
+// so feedings that come due while a door is busy or jammed run back to back once it is free.
+class FeedQueue {
+  public:
+    static const uint8_t maxJobs = 8;
+    static void Init();
+    static void setStalePolicy(FeedStalePolicy policy, long maxAge_s);
+    // Queues a feeding. Returns false if it was merged into a job already queued, or dropped because
+    // the queue is full.
+    static bool push(uint8_t sched, long due);
+    // Takes the oldest job on the schedule. Returns false if there is none.
+    static bool pop(uint8_t sched, FeedJob* job);
+    // Applies the stale policy to jobs that have waited longer than the max age. To be called once per second.
+    static void expire(long now);
+    // The # of jobs queued (on every schedule, or on one).
+    static uint8_t getDepth();
+    static uint8_t getDepth(uint8_t sched);
+    // The # of feedings dropped, as stale or because the queue was full.
+    static uint8_t getDroppedCount();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "I2CBus.h"
+#include <Arduino.h> // Arduino code environment
+#include <Wire.h> // For I2C communication
+#include "Debug.h"
+
+// Bus clock (Hz) for each priority. The DS3231 supports Fast mode; the PCF8574 only Standard mode.
+const static uint32_t rtcClock = 400000, displayClock = 100000;
+// A transaction that takes longer than this (us) has failed.
+const static uint32_t timeout_us = 5000;
+// Bus time (us) the display may use per pass of loop(). About 5 characters at 100 kHz. It is checked
+// before each write, so the last write of a pass can go over it by as long as that write takes.
+const static uint16_t displayBudget_us = 2000;
+// The Wire library's buffer size. Longer writes are split into several transmissions.
+const static uint8_t wireBuffer = 32;
+
+static unsigned long begin_us;
+// The clock the bus is set to (0 = unknown)
+static uint32_t busClock;
+static uint16_t displaySpent_us;
+// Busy time (us) in the current window, and when (ms) the window started
+static unsigned long busy_us, windowStart_ms;
+static uint8_t utilization;
+static uint8_t recoveryCount;
+
+// I2C lines are open drain: a line is pulled low by driving it, and released (to be pulled high by the
+// pull-up resistors) by letting it float. Never driven high, which would short a device pulling it low.
+static void pullLow(uint8_t pin) {
+  digitalWrite(pin, LOW);
+  pinMode(pin, OUTPUT);
+}
+
+static void release(uint8_t pin) {
+  pinMode(pin, INPUT);
+}
+
+// Frees a device stuck holding SDA low (e.g. reset mid-byte) by clocking SCL until it lets go,
+// then sends a STOP and restarts Wire.
+static void recoverBus() {
+  Wire.end();
+  release(SDA);
+  release(SCL);
+  for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+    pullLow(SCL);
+    delayMicroseconds(5);
+    release(SCL);
+    delayMicroseconds(5);
+  }
+  // STOP: SDA goes high while SCL is high
+  pullLow(SCL);
+  pullLow(SDA);
+  delayMicroseconds(5);
+  release(SCL);
+  delayMicroseconds(5);
+  release(SDA);
+  delayMicroseconds(5);
+  Wire.begin();
+  I2CBus::Init();
+  recoveryCount++;
+  DEBUG_PRINTLN(Main, F("I2C bus timed out and was recovered."));
+}
+
+static void I2CBus::Init() {
+  Wire.begin();
+  busClock = 0; // Wire.begin() may have set it back to 100 kHz
+  Wire.setWireTimeout(timeout_us, true);
+}
+
+static void I2CBus::beginPass() {
+  displaySpent_us = 0;
+  // Roll the utilization window over once a second
+  unsigned long elapsed_ms = millis() - windowStart_ms;
+  if (elapsed_ms >= 1000) {
+    utilization = min(100UL, busy_us / (elapsed_ms * 10));
+    busy_us = 0;
+    windowStart_ms = millis();
+  }
+}
+
+static bool I2CBus::hasBudget(I2CPriority p) {
+  return p == I2CPriority::Rtc || displaySpent_us < displayBudget_us;
+}
+
+static void I2CBus::begin(I2CPriority p) {
+  uint32_t clock = p == I2CPriority::Rtc ? rtcClock : displayClock;
+  if (clock != busClock) {
+    Wire.setClock(clock);
+    busClock = clock;
+  }
+  begin_us = micros();
+}
+
+static bool I2CBus::end(I2CPriority p) {
+  unsigned long spent = micros() - begin_us;
+  busy_us += spent;
+  if (p == I2CPriority::Display) {
+    displaySpent_us = min(65535UL, displaySpent_us + spent);
+  }
+  if (Wire.getWireTimeoutFlag()) {
+    Wire.clearWireTimeoutFlag();
+    recoverBus();
+    return false;
+  }
+  return true;
+}
+
+static bool I2CBus::write(uint8_t address, const uint8_t* data, uint8_t n, I2CPriority p) {
+  bool isSent = true;
+  I2CBus::begin(p);
+  for (uint8_t i = 0; i < n && isSent; i += wireBuffer) {
+    Wire.beginTransmission(address);
+    Wire.write(data + i, min(n - i, wireBuffer));
+    isSent = Wire.endTransmission() == 0;
+  }
+  return I2CBus::end(p) && isSent;
+}
+
+static bool I2CBus::readRegisters(uint8_t address, uint8_t reg, uint8_t* data, uint8_t n, I2CPriority p) {
+  bool isRead;
+  I2CBus::begin(p);
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  // Repeated start, so nothing else can take the bus between setting the register and reading it
+  isRead = Wire.endTransmission(false) == 0 && Wire.requestFrom(address, n) == n;
+  for (uint8_t i = 0; isRead && i < n; i++) {
+    data[i] = Wire.read();
+  }
+  return I2CBus::end(p) && isRead;
+}
+
+static uint8_t I2CBus::getUtilization() {
+  return utilization;
+}
+
+static uint8_t I2CBus::getRecoveryCount() {
+  return recoveryCount;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Who is using the bus, most urgent first.
+enum class I2CPriority : uint8_t {
+  Rtc = 0, // The time read each second. Never held back.
+  Display = 1 // LCD updates. Held to a budget per pass of loop(), and can be sent later.
+};
+
+// The one I2C bus, shared by the RTC and the LCD backpack.
+// Runs it as fast as each device allows (Fast mode, 400 kHz, for the RTC; Standard mode, 100 kHz, for
+// the LCD) with a timeout on every transaction, so a device holding the bus can't hang loop(): the
+// transaction fails and the bus is recovered. Display traffic gets a budget
+// of bus time per pass of loop(), and what doesn't fit is sent on a later pass, so a long repaint
+// never holds up the time read. Also measures how busy the bus is.
+class I2CBus {
+  public:
+    // Also to be called after a library's begin() (e.g. the RTC's), which may change the bus clock.
+    static void Init();
+    // Starts a new pass of loop(), with a new display budget.
+    static void beginPass();
+    // True if p may use the bus now. Checked before a write, not during it: a user held to a budget
+    // should keep each write short (ScreenBuffer sends a few cells at a time).
+    static bool hasBudget(I2CPriority p);
+    // Bracket each transaction (or each call into a library that makes some), to time it and to
+    // recover the bus if it timed out. end() returns false if it timed out. They don't nest, and
+    // write() and readRegisters() already bracket themselves.
+    static void begin(I2CPriority p);
+    static bool end(I2CPriority p);
+    // Writes n bytes to a device in one transmission (or as few as the Wire buffer allows).
+    // Returns false if the device didn't acknowledge or the bus timed out.
+    static bool write(uint8_t address, const uint8_t* data, uint8_t n, I2CPriority p);
+    // Reads n bytes from a device's registers, starting at reg, in one transaction.
+    // Returns false if the device didn't acknowledge or the bus timed out.
+    static bool readRegisters(uint8_t address, uint8_t reg, uint8_t* data, uint8_t n, I2CPriority p);
+    // The % of time the bus was busy over the last second.
+    static uint8_t getUtilization();
+    // The # of times the bus timed out and was recovered.
+    static uint8_t getRecoveryCount();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "LcdDriver.h"
+#include <Arduino.h> // Arduino code environment
+#include "I2CBus.h"
+
+// Expander pins
+const static uint8_t rsBit = 0x01, enableBit = 0x04, backlightOnBit = 0x08;
+// HD44780 commands
+const static uint8_t clearDisplay = 0x01, entryLeftToRight = 0x06, displayOn = 0x0C,
+  functionSet4Bit2Line = 0x28, setCgramAddress = 0x40, setDdramAddress = 0x80;
+// DDRAM address of the start of each row, on a 20x4
+const static uint8_t rowStart[] = {0x00, 0x40, 0x14, 0x54};
+
+LcdDriver::LcdDriver(uint8_t address, uint8_t cols, uint8_t rows) {
+  this->address = address;
+  this->cols = cols;
+  this->rows = rows;
+  backlightBit = backlightOnBit;
+  pendingCount = 0;
+  hasFailed = false;
+}
+
+// Queues a byte as two nibbles, high nibble first, each latched by E going high then low.
+// At 100 kHz each expander state takes ~90 us on the bus, so E is high for far longer than the 450 ns
+// needed, and the states between characters cover the 37 us the controller needs per character.
+void LcdDriver::queueByte(uint8_t value, bool isData) {
+  if (pendingCount + 4 > maxPending) {
+    send();
+  }
+  uint8_t lines = backlightBit | (isData ? rsBit : 0);
+  uint8_t high = (value & 0xF0) | lines, low = (value << 4) | lines;
+  pending[pendingCount++] = high | enableBit;
+  pending[pendingCount++] = high;
+  pending[pendingCount++] = low | enableBit;
+  pending[pendingCount++] = low;
+}
+
+// Returns false if the LCD didn't acknowledge or the bus timed out. What was pending is dropped either way.
+bool LcdDriver::send() {
+  bool isSent = true;
+  if (pendingCount > 0) {
+    isSent = I2CBus::write(address, pending, pendingCount, I2CPriority::Display);
+    pendingCount = 0;
+  }
+  hasFailed = hasFailed || !isSent;
+  return isSent;
+}
+
+void LcdDriver::command(uint8_t value) {
+  queueByte(value, false);
+  send();
+}
+
+void LcdDriver::init() {
+  // Power-on: wait for the controller, then get it into 4-bit mode from whatever mode it was in.
+  // It starts in 8-bit mode, where each E pulse is a whole command and only D4 - D7 are wired.
+  const uint8_t wakeup[] = {0x30, 0x30, 0x30, 0x20};
+  const unsigned int wakeupDelay_us[] = {4500, 4500, 150, 150};
+  delay(50);
+  for (uint8_t i = 0; i < 4; i++) {
+    uint8_t state[] = {(uint8_t)(wakeup[i] | backlightBit | enableBit), (uint8_t)(wakeup[i] | backlightBit)};
+    I2CBus::write(address, state, 2, I2CPriority::Display);
+    delayMicroseconds(wakeupDelay_us[i]);
+  }
+  command(functionSet4Bit2Line);
+  command(displayOn);
+  command(entryLeftToRight);
+  clear();
+}
+
+void LcdDriver::backlight() {
+  backlightBit = backlightOnBit;
+  I2CBus::write(address, &backlightBit, 1, I2CPriority::Display);
+}
+
+void LcdDriver::noBacklight() {
+  backlightBit = 0;
+  I2CBus::write(address, &backlightBit, 1, I2CPriority::Display);
+}
+
+void LcdDriver::clear() {
+  command(clearDisplay);
+  delayMicroseconds(2000);
+}
+
+void LcdDriver::setCursor(uint8_t col, uint8_t row) {
+  if (row >= rows) {
+    row = rows - 1;
+  }
+  queueByte(setDdramAddress | (rowStart[row] + col), false);
+}
+
+void LcdDriver::createChar(uint8_t location, uint8_t* charmap) {
+  queueByte(setCgramAddress | ((location & 0x07) << 3), false);
+  for (uint8_t i = 0; i < 8; i++) {
+    queueByte(charmap[i], true);
+  }
+  send();
+}
+
+size_t LcdDriver::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t LcdDriver::write(const uint8_t* buffer, size_t size) {
+  // A long run is sent in several parts (by queueByte()), any of which may fail
+  hasFailed = false;
+  for (size_t i = 0; i < size; i++) {
+    queueByte(buffer[i], true);
+  }
+  send();
+  return hasFailed ? 0 : size;
+}
\ No newline at end of file
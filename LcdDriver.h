@@ -0,0 +1,41 @@
+#ifndef LCDDRIVER_H
+#define LCDDRIVER_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Driver for an HD44780 character LCD behind a PCF8574 I2C backpack (in place of LiquidCrystal_I2C).
+// The controller is run in 4-bit mode, so each byte is two nibbles, and each nibble is latched by
+// pulsing the enable line: two expander writes, with E high then low. LiquidCrystal_I2C sends each of
+// those as its own transmission; here every expander state of a command or a run of characters is
+// packed into one buffer and sent with as few transmissions as the Wire buffer allows.
+//
+// Backpack pins: P0 = RS, P1 = RW, P2 = E, P3 = backlight, P4 - P7 = D4 - D7.
+class LcdDriver : public Print {
+  public:
+    LcdDriver(uint8_t address, uint8_t cols, uint8_t rows);
+    void init();
+    void backlight();
+    void noBacklight();
+    // Slow (about 2 ms). ScreenBuffer overwrites what changed instead, so this is only needed at startup.
+    void clear();
+    // Sent with the next write, to save a transmission.
+    void setCursor(uint8_t col, uint8_t row);
+    void createChar(uint8_t location, uint8_t* charmap);
+    // Both return 0 if the LCD didn't get it all (no acknowledge, or the bus timed out).
+    size_t write(uint8_t c);
+    // Sends a run of characters (and any setCursor() before it) in one go.
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+  private:
+    // 4 expander states per byte. 8 bytes fill the Wire buffer.
+    static const uint8_t maxPending = 32;
+    uint8_t address, cols, rows, backlightBit;
+    uint8_t pending[maxPending], pendingCount;
+    // Whether a send() failed since the last write() began
+    bool hasFailed;
+    void queueByte(uint8_t value, bool isData);
+    bool send();
+    void command(uint8_t value);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "MemoryMonitor.h"
+#include <Arduino.h> // Arduino code environment
+#include "EventBus.h"
+#include "Debug.h"
+
+#ifdef __AVR__
+// Set up by avr-libc's malloc
+extern char __heap_start;
+extern char* __brkval;
+extern size_t __malloc_margin;
+struct __freelist {
+  size_t sz;
+  struct __freelist* nx;
+};
+extern struct __freelist* __flp;
+#endif
+
+// Unused RAM is filled with this. The stack high-water mark is where it stops.
+const static uint8_t paintByte = 0xC5;
+// Bytes just below the stack pointer left alone by Init(), for its own calls.
+const static uint8_t stackGuard = 32;
+// # of paint bytes in a row that mark where the stack has never reached. Locals that were never
+// written leave shorter runs of paint inside the stack.
+const static uint8_t paintRun = 16;
+
+static MemoryStats stats;
+static bool isLow = false;
+
+#ifdef __AVR__
+static uint8_t* heapTop() {
+  return (uint8_t*)(__brkval ? __brkval : &__heap_start);
+}
+#endif
+
+static void MemoryMonitor::Init() {
+#ifdef __AVR__
+  uint8_t* p = heapTop();
+  uint8_t* end = (uint8_t*)SP - stackGuard;
+  while (p < end) {
+    *p++ = paintByte;
+  }
+#endif
+}
+
+static void MemoryMonitor::Check() {
+#ifdef __AVR__
+  uint8_t* top = heapTop();
+  uint8_t* sp = (uint8_t*)SP;
+  // The stack has never reached below the first run of paint (from the stack down). Scanning from the
+  // heap up instead would stop at the bytes freed heap blocks left above the break (free() lowers it).
+  uint8_t* p = sp;
+  uint8_t run = 0;
+  while (p > top && run < paintRun) {
+    run = *p == paintByte ? run + 1 : 0;
+    p--;
+  }
+  stats.stackFree = p + run + 1 - top;
+  stats.heapBreak = (uint16_t)top;
+  // Walk the free list
+  stats.freeList = 0;
+  stats.largestFree = sp - top > (int)__malloc_margin ? sp - top - __malloc_margin : 0;
+  for (struct __freelist* f = __flp; f; f = f->nx) {
+    stats.freeList += f->sz + sizeof(size_t);
+    stats.largestFree = max(stats.largestFree, (uint16_t)f->sz);
+  }
+#else
+  // Nothing to measure off the board
+  stats = { 0xFFFF, 0, 0, 0xFFFF };
+#endif
+  if (stats.stackFree < LOW_MEMORY_MARGIN && !isLow) {
+    isLow = true;
+    EventBus::post(EventType::LowMemory, min(stats.stackFree, (uint16_t)255));
+    MemoryMonitor::printStats();
+  }
+  else if (stats.stackFree >= LOW_MEMORY_MARGIN) {
+    isLow = false;
+  }
+}
+
+static MemoryStats MemoryMonitor::getStats() {
+  return stats;
+}
+
+static void MemoryMonitor::printStats() {
+  DEBUG_PRINTLN(Main, "Mem: stack free " + String(stats.stackFree) + ", brk " + String(stats.heapBreak)
+    + ", free list " + String(stats.freeList) + ", largest " + String(stats.largestFree));
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Posts LowMemory when fewer than this many bytes have stayed free between the heap and the stack.
+#ifndef LOW_MEMORY_MARGIN
+#define LOW_MEMORY_MARGIN 128
+#endif
+
+struct MemoryStats {
+  uint16_t stackFree; // Bytes between the top of the heap and the deepest the stack has reached
+  uint16_t heapBreak; // Address of the top of the heap
+  uint16_t freeList; // Bytes in freed blocks below the top of the heap
+  uint16_t largestFree; // The largest block malloc could hand out right now
+};
+
+// Measures how close the stack and heap are to colliding on the 2 KB of SRAM.
+class MemoryMonitor {
+  public:
+    // Fills the unused RAM between the heap and the stack with a known pattern.
+    // Call as early in setup() as possible. Only paints: it runs before EventBus::Init(), so the first
+    // measurement (and any LowMemory) waits for the first Check().
+    static void Init();
+    // Measures memory use, posting LowMemory once when the free margin drops below LOW_MEMORY_MARGIN.
+    static void Check();
+    static MemoryStats getStats();
+    // Prints the last measurements over Serial (debug only).
+    static void printStats();
+};
+
+#endif
\ No newline at end of file
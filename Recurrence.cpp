@@ -0,0 +1,105 @@
+#include <Arduino.h> // Arduino code environment
+#include "Recurrence.h"
+
+const static uint8_t intervalFlag = 0x80;
+const static uint8_t allWeekdays = 0x7F;
+
+// Repeats every day.
+Recurrence Recurrence::daily() {
+  Recurrence r;
+  r.days = 0;
+  r.anchorDay = 0;
+  return r;
+}
+
+// Repeats on the weekdays set in weekdayMask (bit 0 = Sunday ... bit 6 = Saturday).
+Recurrence Recurrence::weekly(uint8_t weekdayMask) {
+  Recurrence r;
+  r.days = ~weekdayMask & allWeekdays;
+  r.anchorDay = 0;
+  return r;
+}
+
+// Repeats every n days (1 - 127), starting on startDay.
+Recurrence Recurrence::everyNDays(uint8_t n, uint16_t startDay) {
+  Recurrence r;
+  r.days = intervalFlag | (n & allWeekdays);
+  r.anchorDay = startDay;
+  return r;
+}
+
+// Returns the weekday of a day number: 0 = Sunday ... 6 = Saturday.
+uint8_t Recurrence::weekday(uint16_t day) {
+  return (day + 6) % 7; // Day 0 (2000-01-01) was a Saturday.
+}
+
+// Converts a date (year 2000 - 2099) to its day number.
+uint16_t Recurrence::dayNumber(uint16_t year, uint8_t month, uint8_t day) {
+  const static uint16_t daysBeforeMonth[] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+  uint8_t y = year - 2000;
+  // Every 4th year (starting with 2000) is a leap year in 2000 - 2099.
+  uint16_t n = y * 365 + (y + 3) / 4 + daysBeforeMonth[(month - 1) % 12] + day - 1;
+  if (y % 4 == 0 && month > 2) {
+    n++;
+  }
+  return n;
+}
+
+bool Recurrence::isInterval() {
+  return days & intervalFlag;
+}
+// The weekdays this repeats on (bit 0 = Sunday ... bit 6 = Saturday), or 0 for every-N-days rules.
+uint8_t Recurrence::getWeekdays() {
+  return isInterval() ? 0 : ~days & allWeekdays;
+}
+// The number of days between repeats, or 0 for weekday rules.
+uint8_t Recurrence::getInterval() {
+  return isInterval() ? days & allWeekdays : 0;
+}
+// Returns true if the rule repeats on at least one day.
+bool Recurrence::isValid() {
+  return isInterval() ? getInterval() > 0 : getWeekdays() != 0;
+}
+
+// Returns true if the rule occurs on the day number.
+bool Recurrence::occursOn(uint16_t day) {
+  return daysUntil(day) == 0;
+}
+
+// Returns the number of days from the day number until the rule next occurs (0 = it occurs on that day),
+// or never if it never occurs. Constant time, whatever the rule.
+uint16_t Recurrence::daysUntil(uint16_t day) {
+  if (!isValid()) {
+    return never;
+  }
+  if (isInterval()) {
+    uint8_t n = getInterval();
+    if (day < anchorDay) {
+      return anchorDay - day;
+    }
+    uint8_t r = (day - anchorDay) % n;
+    return r == 0 ? 0 : n - r;
+  }
+  // Rotate the weekday mask so that bit 0 is this day's weekday; the lowest set bit is then the next day it occurs.
+  uint8_t w = Recurrence::weekday(day);
+  uint8_t mask = getWeekdays();
+  uint8_t rotated = ((mask >> w) | (mask << (7 - w))) & allWeekdays;
+  return __builtin_ctz(rotated);
+}
+
+// Returns "Daily", the weekdays it occurs on (e.g. "-MTWTF-"), or every N days (e.g. "Every 2d").
+String Recurrence::toString() {
+  const static char letters[] PROGMEM = "SMTWTFS";
+  if (isInterval()) {
+    return String(F("Every ")) + String(getInterval()) + 'd';
+  }
+  uint8_t mask = getWeekdays();
+  if (mask == allWeekdays) {
+    return F("Daily");
+  }
+  String s = "";
+  for (uint8_t i = 0; i < 7; i++) {
+    s += (mask & (1 << i)) ? (char)pgm_read_byte(&letters[i]) : '-';
+  }
+  return s;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Which days a scheduled time repeats on, packed into 3 bytes.
+// Days are numbered from 2000-01-01 (day 0, a Saturday).
+// A zeroed Recurrence repeats every day.
+class Recurrence {
+  public:
+    // Bit 7 clear: bits 0-6 are the weekdays to skip (bit 0 = Sunday ... bit 6 = Saturday).
+    // Bit 7 set: bits 0-6 are N, for a time that repeats every N days.
+    uint8_t days;
+    // For every-N-days rules, a day the time occurs on.
+    uint16_t anchorDay;
+    // What daysUntil() returns for a rule that never occurs
+    static const uint16_t never = 0xFFFF;
+    static Recurrence daily();
+    static Recurrence weekly(uint8_t weekdayMask);
+    static Recurrence everyNDays(uint8_t n, uint16_t startDay);
+    static uint8_t weekday(uint16_t day);
+    static uint16_t dayNumber(uint16_t year, uint8_t month, uint8_t day);
+    bool isInterval();
+    uint8_t getWeekdays();
+    uint8_t getInterval();
+    bool isValid();
+    bool occursOn(uint16_t day);
+    uint16_t daysUntil(uint16_t day);
+    String toString();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "RunningStats.h"
+#include <math.h>
+
+void RunningStats::clear() {
+  n = 0;
+  mean = 0;
+  m2 = 0;
+}
+
+void RunningStats::add(float x, uint16_t window) {
+  if (n < window) {
+    n++;
+  }
+  else {
+    m2 -= m2 / n;
+  }
+  float delta = x - mean;
+  mean += delta / n;
+  m2 += delta * (x - mean);
+}
+
+float RunningStats::variance() const {
+  return n > 1 ? m2 / (n - 1) : 0;
+}
+
+float RunningStats::spread() const {
+  return sqrt(variance());
+}
\ No newline at end of file
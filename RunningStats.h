@@ -0,0 +1,19 @@
+#ifndef RUNNINGSTATS_H
+#define RUNNINGSTATS_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Running mean and variance of a series of readings, in constant memory (Welford's method).
+// Once window samples have been taken, each new sample is weighted as if the oldest dropped out,
+// so older readings fade and the stats follow slow drift (e.g. ambient light, a dusty sensor).
+struct RunningStats {
+  uint16_t n;
+  float mean, m2;
+
+  void clear();
+  void add(float x, uint16_t window);
+  float variance() const;
+  float spread() const; // Standard deviation
+};
+
+#endif
\ No newline at end of file
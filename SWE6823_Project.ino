@@ -6,64 +6,170 @@
 //  Spring Semester 2025
 //  SWE 6823 Embedded Systems
 
-#include <I2C_RTC.h> // For the RTC module
 #include <Arduino.h> // Arduino code environment
 #include <Wire.h> // For I2C communication
 #include "SystemUI.h"
 #include "TimeMgmt.h"
 #include "TimeValue.h"
 #include "Debug.h"
+#include "MemoryMonitor.h"
+#include "Trace.h"
+#include "Capture.h"
+#include "I2CBus.h"
 #include "SystemUtil.h"
 #include "DoorMgmt.h"
+#include "EventBus.h"
+#include "FeedQueue.h"
+#include "Tunables.h"
+#include "TimeSync.h"
+#include "Timers.h"
+#include "SerialCommands.h"
 
 #pragma region Global_Variables
 // Pin number (Constant)
 const uint8_t 
   LED_Dispensing = 7,
   Btn_Up = 2, Btn_Down = 4, Btn_OK = 5, Btn_Menu = 6,
-  Direction = 12, PWM = 3, Brake = 9,
-  Photoresistor = A1;
+  // The RTC's SQW output. Pins 2 and 3 (the external interrupts) are taken, so it's on a pin change interrupt.
+  RTC_SquareWave = A3;
+// The number of food doors. The motor shield has two channels (A and B), so at most 2.
+const uint8_t doorCount = 1;
+// Pin numbers for each door (Constant), by motor shield channel: {A, B}
+const uint8_t
+  Direction[] = {12, 13}, PWM[] = {3, 11}, Brake[] = {9, 8},
+  Photoresistor[] = {A1, A2},
+  // Channel B's current sense is on A1, which the first door's photoresistor uses, so the second door goes without.
+  CurrentSense[] = {A0, DoorMgmt::noSensePin};
+DoorMgmt doors[doorCount];
+// The name of each door's feeding schedule.
+const char* const scheduleNames[] = {"Pet 1", "Pet 2"};
 // True = the current input is already handled, otherwise False
-bool isInputHandled, isDispensing;
+bool isInputHandled;
+// True = the door at that index is running its dispensing routine, otherwise False
+bool isDispensing[doorCount];
 // True = button is pressed, otherwise False
 bool upPressed, downPressed, okPressed, menuPressed;
-// The amount of time (ms) between running this task's code.
-const long intervalTime = 1000, intervalUi = 10, intervalDoorCheck = 100;
-volatile bool isTimeReady = false, isUiReady = false, isSystemResetReady = false, isDoorCheckReady = false;
+// Hold-to-repeat for Up and Down (ms): the wait before the first repeat, and the time between
+// repeats, which shrinks by a quarter each repeat down to the minimum.
+const unsigned long repeatDelay_ms = 500, repeatStartInterval_ms = 150, repeatMinInterval_ms = 30;
+unsigned long nextRepeat_ms, repeatInterval_ms;
+// The amount of time (ms) between running this task's code. The time, UI and door tasks' intervals
+// are Tunables (IntervalTime, IntervalUi and IntervalDoorCheck). The time task runs on the RTC's own
+// second instead while its square wave is running.
+const unsigned long intervalCurrent = 2;
+// When (ms) each task was last due.
+unsigned long lastTime_ms, lastUi_ms, lastDoorCheck_ms, lastCurrent_ms;
+// # of time task runs, mod 10 (for the debug memory stats)
+uint8_t timeTicks = 0;
+volatile bool isTimeReady = false, isUiReady = false, isSystemResetReady = false, isDoorCheckReady = false,
+  isCurrentReady = false;
+// True = the RTC is set up (the last boot stage), otherwise False
+bool isClockReady = false;
+// Resets the system once "Resetting." has been shown for a moment
+TimerId resetTimer = Timers::none;
 
-bool runWithDebug = false; // Enable debugging/diagnostic printing
+const bool runWithDebug = DEBUG_ENABLED; // Debugging/diagnostic printing, set in Debug.h
+// Whether anything that takes commands over Serial is compiled in. If not, Serial (and its ~160 bytes of
+// buffers) isn't linked in at all.
+const bool hasSerialCommands = TIMESYNC_ENABLED || TUNABLES_SERIAL_ENABLED || TRACE_ENABLED;
 
 // TODO: error led?
+
+void onDispenseEvent(Event e); // Defined in Helper_Methods
+void onResetTimer(uint8_t arg); // Defined in Helper_Methods
 #pragma endregion Global_Variables
 
 // Runs once upon startup.
+// Boot is staged so that nothing blocks: the doors home in the background while the display and
+// then the RTC come up, and the UI takes input as soon as the display is ready.
 void setup() {
+  // Start the watchdog first, so a hang anywhere restarts the system.
+  watchdogInit();
+  // Mark the free RAM before anything else allocates, so the stack's deepest point can be found later.
+  MemoryMonitor::Init();
   // Pin modes
   pinMode(LED_Dispensing, OUTPUT);
   pinMode(Btn_Up, INPUT);
   pinMode(Btn_Down, INPUT);
   pinMode(Btn_OK, INPUT);
   pinMode(Btn_Menu, INPUT);
-  pinMode(Photoresistor, INPUT);
-  // Initialize processes.
-  DoorMgmt::Init(Direction, PWM, Brake, Photoresistor);
-  SystemUI::Init(runWithDebug, "v1.0.1");
-  TimeMgmt::Init();
-  
+  for (uint8_t i = 0; i < doorCount; i++) {
+    pinMode(Photoresistor[i], INPUT);
+  }
+  // Commands over Serial (e.g. the trace dump, tunables, clock sync) go to the modules that register for them
+  SerialCommands::Init();
   // Debugger uses Serial Monitor
   if (runWithDebug) {
     Debug::Init();
+    DEBUG_PRINT(Main, F("Reset cause: "));
+    DEBUG_PRINTLN(Main, getResetCauseName());
+  }
+  // Trace recorder (if compiled in) also uses Serial Monitor
+  Trace::Init();
+
+  // [Boot Stage 1]: Doors and schedules (no waiting on hardware)
+  // The tunables come first, as everything else reads them. They can be changed over Serial too.
+  Tunables::Init();
+  EventBus::Init();
+  // Timeouts and pauses (door moves, messages) run on timers, from the first door homing on
+  Timers::Init();
+  // Waveform capture (if compiled in) sends over Serial Monitor, and watches for jams
+  Capture::Init();
+  // The clock can be synced from a PC over Serial (if compiled in)
+  TimeSync::Init();
+  FeedQueue::Init();
+  for (uint8_t i = 0; i < doorCount; i++) {
+    doors[i].Init(i, Direction[i], PWM[i], Brake[i], Photoresistor[i], CurrentSense[i]);
+  }
+  // Each door dispenses on its own schedule.
+  for (uint8_t i = 0; i < doorCount; i++) {
+    doors[i].bindSchedule(TimeMgmt::addSchedule(scheduleNames[i]));
+  }
+  // After a warm restart (e.g. watchdog), pick up the schedules where they left off.
+  bool isWarm = TimeMgmt::restoreWarmState();
+  if (runWithDebug && !isWarm) {
     // Other debugging code
-    for (int i = 0 ; i < 12; i++) { // Add full schedule of times
-      TimeMgmt::setScheduleTime(i, 0, i*2 + 1, i*3);
-    } 
+    ScheduleEdit edits[Schedule::maxTimes];
+    uint8_t results[Schedule::maxTimes];
+    for (int i = 0 ; i < Schedule::maxTimes; i++) { // Add full schedule of times
+      edits[i] = { ScheduleEditOp::Add, 0, TimeValue(0, i*2 + 1, i*3), Recurrence::daily() };
+    }
+    TimeMgmt::applyScheduleBatch(0, edits, Schedule::maxTimes, results);
   }
+  // Close the doors in the background. After a warm restart, only doors that were mid-routine need it.
+  for (uint8_t i = 0; i < doorCount; i++) {
+    if (!isWarm || (getWarmState()->busyDoors & (1 << i))) {
+      doors[i].homeDoor();
+    }
+  }
+  getWarmState()->busyDoors = 0;
+  saveWarmState();
+
+  // [Boot Stage 2]: Display. The UI is interactive from here on.
+  I2CBus::Init();
+  SystemUI::Init(runWithDebug, "v1.0.1");
+  EventBus::subscribe(EventType::DispenseStarted, onDispenseEvent);
+  EventBus::subscribe(EventType::DispenseDone, onDispenseEvent);
+  SystemUI::UpdateUI();
+  SystemUI::SetBootTime(millis());
 
-  // Force close the door.
-  DoorMgmt::forceCloseDoor(true);
+  // [Boot Stage 3]: RTC, on the first pass of loop().
 }
 
 #pragma region Helper_Methods
+// Returns true once interval (ms) has passed since the task was last due, by elapsed time rather than
+// by millis() landing on a multiple of the interval, so a pass of loop() that runs long can't skip a task.
+// A task that falls more than one interval behind runs once, then keeps its cadence from now.
+bool isTaskDue(unsigned long now, unsigned long* lastDue, unsigned long interval) {
+  if (now - *lastDue < interval) {
+    return false;
+  }
+  *lastDue += interval;
+  if (now - *lastDue >= interval) {
+    *lastDue = now;
+  }
+  return true;
+}
 // Updates the ___Pressed variables: True = pressed, False = not pressed.
 void readInput() {
   upPressed = digitalRead(Btn_Up) == HIGH;
@@ -71,18 +177,45 @@ void readInput() {
   okPressed = digitalRead(Btn_OK) == HIGH;
   menuPressed = digitalRead(Btn_Menu) == HIGH;
 }
-// Updates the LED and `isDispensing` variable based on value of arg.
-void toggleDispensingStatus(bool arg) {
+// Posts a button press (handled by SystemUI, and by DoorMgmt for OK).
+void postButton(UiButton b) {
+  const char* const names[] = {"UP", "DOWN", "OK", "MENU"};
+  DEBUG_PRINT(Main, names[(uint8_t)b]);
+  DEBUG_PRINTLN(Main, F(" pressed"));
+  TRACE(Button, (uint8_t)b, 0);
+  EventBus::post(EventType::ButtonPressed, (uint8_t)b);
+}
+// Updates the door's `isDispensing` variable based on value of arg.
+// The LED is on while any door is dispensing.
+void toggleDispensingStatus(uint8_t door, bool arg) {
+  bool anyDispensing = false;
+  isDispensing[door] = arg;
   if (arg) {
-    isDispensing = true;
-    digitalWrite(LED_Dispensing, HIGH);
-    Debug::println("It is now feeding time!");
+    DEBUG_PRINTLN(Main, F("It is now feeding time!"));
   }
   else {
-    isDispensing = false;
-    digitalWrite(LED_Dispensing, LOW);
-    Debug::println("Done with feeding routine.");
+    DEBUG_PRINTLN(Main, F("Done with feeding routine."));
+  }
+  for (uint8_t i = 0; i < doorCount; i++) {
+    anyDispensing = anyDispensing || isDispensing[i];
   }
+  digitalWrite(LED_Dispensing, anyDispensing ? HIGH : LOW);
+}
+// Keeps the dispensing status up to date as doors start and finish their food routine.
+// Also remembers which doors are busy, in case of a warm restart.
+void onDispenseEvent(Event e) {
+  toggleDispensingStatus(e.arg, e.type == EventType::DispenseStarted);
+  if (e.type == EventType::DispenseStarted) {
+    getWarmState()->busyDoors |= 1 << e.arg;
+  }
+  else {
+    getWarmState()->busyDoors &= ~(1 << e.arg);
+  }
+  saveWarmState();
+}
+// Resets the system (once the reset message has been shown).
+void onResetTimer(uint8_t) {
+  systemReset(true); // in SystemUtil.cpp
 }
 
 #pragma endregion Helper_Methods
@@ -91,72 +224,71 @@ void toggleDispensingStatus(bool arg) {
 void loop() {
   // The # of ms elapsed since the program started.
   unsigned long now = millis();
+  watchdogFeed();
+  I2CBus::beginPass();
 
-  isTimeReady = now % intervalTime == 0;
-  isUiReady = now % intervalUi == 0;
-  isDoorCheckReady = now % intervalDoorCheck == 0;
+  isTimeReady = TimeMgmt::isSquareWaveRunning() ? TimeMgmt::takeSecond()
+    : isTaskDue(now, &lastTime_ms, Tunables::get(TunableId::IntervalTime));
+  isUiReady = isTaskDue(now, &lastUi_ms, Tunables::get(TunableId::IntervalUi));
+  isDoorCheckReady = isTaskDue(now, &lastDoorCheck_ms, Tunables::get(TunableId::IntervalDoorCheck));
+  isCurrentReady = isTaskDue(now, &lastCurrent_ms, intervalCurrent);
   isSystemResetReady = SystemUI::IsResetReady();
 
-  // [Time Task]: Update time, check for schedule time (once per 1 s)
+  // [Boot Task]: Last boot stage, after the UI is already interactive.
+  if (!isClockReady) {
+    TimeMgmt::Init(RTC_SquareWave);
+    isClockReady = true;
+    DEBUG_PRINTLN(Main, "Boot done in " + String(millis()) + " ms");
+  }
+
+  // [Serial Commands]: Run the commands that arrived over Serial, e.g. clock sync requests (every pass)
+  if (hasSerialCommands) {
+    SerialCommands::Poll();
+  }
+  // [Time Sync]: Watch the RTC's second just before a clock set (if compiled in, without the square wave; every pass)
+  TimeSync::Poll();
+
+  // [Time Task]: Update time, check for schedule time (once per 1 s, on the RTC's second)
   if (isTimeReady) {
-    // Check if current time is feeding time
-    bool isFoodTime = TimeMgmt::isFeedingTime();
-
-    // If this time is a time on the food schedule and we are not already dispensing,
-    if (isFoodTime && !isDispensing) {
-      // Then start dispensing routine.
-      toggleDispensingStatus(true);
-      SystemUI::SetText(String("Dispensing food."), -1);
-      DoorMgmt::dispenseFood();
-    }
-    // If doormgmt is done with dispensing routine,
-    if (DoorMgmt::isDispensingFood() == false && isDispensing == true) {
-      // Then stop routine and resume UI.
-      toggleDispensingStatus(false);
-      SystemUI::UnpauseUi();
-      SystemUI::UpdateUI();
-    }
-    
-    // sync SystemUI's currentTime with the current time from timeMgmt
-    SystemUI::UpdateTime(TimeMgmt::getSysTime());
-    if (SystemUI::ErrorTick()) { // clock tick for error message on a time limit 
-      SystemUI::UnpauseUi();
-      SystemUI::UpdateUI();
-    }
+    TRACE(Task, (uint8_t)TraceTask::Time, 0);
+    // Posts TimeChanged, and FeedDue for each schedule with a time due now
+    TimeMgmt::Tick();
+    // Posts LowMemory if the stack and heap are getting close
+    MemoryMonitor::Check();
 
     //(Debug only)
     if (runWithDebug) {
-      Debug::println(String(DoorMgmt::detectJam()) + " = Door jam");
+      if (timeTicks == 0) { // Every 10 time ticks
+        MemoryMonitor::printStats();
+      }
+      timeTicks = (timeTicks + 1) % 10;
+      for (uint8_t i = 0; i < doorCount; i++) {
+        DEBUG_PRINTLN(Main, String(doors[i].detectJam()) + " = Door jam");
+      }
     }
   }
-  // [UI Task]: Read inputs, update UI (once per 10 ms)
+  // [UI Task]: Read inputs (once per 10 ms)
   if (isUiReady) {
     // Check for input
     readInput();
     if (upPressed || downPressed || okPressed || menuPressed) {
       // If just one button is pressed,
       if (!isInputHandled && (upPressed + downPressed + okPressed + menuPressed == 1)) {
-        // Respond to button input
-        if (upPressed) {
-          Debug::println("UP pressed");
-          SystemUI::Input(UiButton::Up);
-        }
-        if (downPressed) {
-          Debug::println("DOWN pressed");
-          SystemUI::Input(UiButton::Down);
-        }
-        if (okPressed) {
-          Debug::println("OK pressed");
-          SystemUI::Input(UiButton::OK);
-          if (DoorMgmt::isDispensingFood()) {
-            DoorMgmt::okPressedHandler();
-          }
-        }
-        if (menuPressed) {
-          Debug::println("MENU pressed");
-          SystemUI::Input(UiButton::Menu);
-        }
-        SystemUI::UpdateUI();
+        // Post the button input (handled by SystemUI, and by DoorMgmt for OK)
+        if (upPressed) postButton(UiButton::Up);
+        if (downPressed) postButton(UiButton::Down);
+        if (okPressed) postButton(UiButton::OK);
+        if (menuPressed) postButton(UiButton::Menu);
+        // Up and Down repeat while held, starting after repeatDelay_ms
+        nextRepeat_ms = now + repeatDelay_ms;
+        repeatInterval_ms = repeatStartInterval_ms;
+      }
+      // If Up or Down alone is still held, repeat it, a little faster each time
+      else if (isInputHandled && (upPressed != downPressed) && !okPressed && !menuPressed
+        && (long)(now - nextRepeat_ms) >= 0) {
+        postButton(upPressed ? UiButton::Up : UiButton::Down);
+        nextRepeat_ms = now + repeatInterval_ms;
+        repeatInterval_ms = max(repeatMinInterval_ms, repeatInterval_ms * 3 / 4);
       }
 
       isInputHandled = true;
@@ -164,21 +296,44 @@ void loop() {
     else {
       isInputHandled = false;
     }
-    // Update UI as needed.
-    if (SystemUI::IsTimeNeeded() && isTimeReady) {
-      SystemUI::UpdateUI();
-    }
   }
 
-  // [Door Task]: For operating door (clock tick once per 0.1 s)
+  // [Door Task]: For operating the doors (clock tick once per 0.1 s)
   if (isDoorCheckReady) {
-    DoorMgmt::ClockTick();
+    // Only traced while a door is busy or has a feeding queued (otherwise the ticks do nothing),
+    // to keep the trace short
+    for (uint8_t i = 0; TRACE_ENABLED && i < doorCount; i++) {
+      if (doors[i].isDoorMoving() || isDispensing[i] || FeedQueue::getDepth(doors[i].getScheduleId()) > 0) {
+        TRACE(Task, (uint8_t)TraceTask::Door, 0);
+        break;
+      }
+    }
+    for (uint8_t i = 0; i < doorCount; i++) {
+      doors[i].ClockTick();
+    }
+  }
+
+  // [Current Task]: Stop any door whose motor has stalled (once per 2 ms)
+  if (isCurrentReady) {
+    for (uint8_t i = 0; i < doorCount; i++) {
+      doors[i].SenseTick();
+    }
   }
 
+  // [Timers]: Run the callbacks of timers that are due, e.g. ending door moves (every pass)
+  Timers::Poll();
+
+  // [Capture Task]: Sample a moving door and send finished captures (if compiled in; every pass)
+  Capture::Poll();
+
+  // Send posted events to their subscribers (UI updates, feedings, door status)
+  EventBus::Dispatch();
+  // Send what's left of the screen update, within the display's share of the bus
+  SystemUI::FlushTick();
+
   // This is not a task like the others. If the user enters OK when prompted to reset system, this occurs.
-  if (isSystemResetReady) {
-    SystemUI::SetText("Resetting.", 5);
-    delay(1000);
-    systemReset(true); // in SystemUtil.cpp
+  if (isSystemResetReady && !Timers::isArmed(resetTimer)) {
+    SystemUI::SetText(F("Resetting."), SystemUI::noTimeLimit);
+    resetTimer = Timers::start(1000, onResetTimer);
   }
-}
+}
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include <Arduino.h> // Arduino code environment
 #include "TimeValue.h"
 #include "Schedule.h"
+#include "Tunables.h"
 #include "Debug.h"
 
 Schedule::Schedule() {
-  schedule = new TimeValue[12];
+  schedule = new TimeValue[maxTimes];
+  rules = new Recurrence[maxTimes];
   count = 0;
 }
 
@@ -13,18 +15,26 @@ void Schedule::sort() {
   // Bubble sort is fine as our schedule has at max 12 entries.
   for (int i = 0; i < count; i++) {
     for (int j = 0; j < count - i - 1; j++) {
-      if (schedule[j].totalSeconds() > schedule[j + 1].totalSeconds()) {
+      if (schedule[j] > schedule[j + 1]) {
         // Swap elements
         TimeValue tmp = schedule[j];
         schedule[j] = schedule[j + 1];
         schedule[j + 1] = tmp;
+        Recurrence tmpRule = rules[j];
+        rules[j] = rules[j + 1];
+        rules[j + 1] = tmpRule;
       }
     }
   }
 
-  Debug::println("Done sorting, the schedule is now: ");
+  DEBUG_PRINTLN(Time, F("Done sorting, the schedule is now: "));
+  Schedule::printSchedule();
+}
+
+// Prints every time in the schedule to the debugger.
+void Schedule::printSchedule() {
   for (int i = 0; i < count; i++) {
-    Debug::println(schedule[i].toString());
+    DEBUG_PRINTLN(Time, schedule[i].toString() + " " + rules[i].toString());
   }
 }
 
@@ -32,12 +42,16 @@ TimeValue Schedule::getTime(uint8_t index) {
   return schedule[index];
 }
 
+// Returns the days the time at index repeats on.
+Recurrence Schedule::getRule(uint8_t index) {
+  return rules[index];
+}
+
 // Returns true if no conflicts, or false if the time parameter (HH:MM:SS) has conflicts with any times in the schedule.
 // Optionally skips checking at an index, for example if the time at index will be updated.
 bool Schedule::checkTimeConflicts(uint8_t h, uint8_t m, uint8_t s, bool do_skip = false, uint8_t skip_index = 255) {
-  long minimumTimeDiff = 60; // The number of seconds apart all times must be at minimum.
-  long t1 = h, t2 = m, t3 = s; // Intentionally converting to Long to prevent overflowing. These are tmp vars.
-  long timeAmnt = t1 * 3600 + t2 * 60 + t3; // The time parameter converted to total seconds.
+  long minimumTimeDiff = Tunables::get(TunableId::MinTimeDiff); // The number of seconds apart all times must be at minimum.
+  TimeValue time(h, m, s);
 
   // For each time in the schedule,
   for (uint8_t i = 0; i < count; i++) {
@@ -45,15 +59,9 @@ bool Schedule::checkTimeConflicts(uint8_t h, uint8_t m, uint8_t s, bool do_skip
     if (do_skip && i == skip_index) {
       continue;
     }
-    // Find the difference between total seconds of this time and the time parameter
-    t3 = schedule[i].totalSeconds();
-    t1 = abs(t3 - timeAmnt);
-// Check for wrap-around conflicts (e.g. 23:59:30 and 0:00:01 are 31 secs apart, not 86369.)
-    t2 = abs((t3 + 86400) % 86400 - timeAmnt);
-    t3 = abs((timeAmnt + 86400) % 86400 - t3);
-
-    // If that difference is less than minimumTimeDiff, return false (There is a time conflict.)
-    if (t1 < minimumTimeDiff || t2 < minimumTimeDiff || t3 < minimumTimeDiff) {
+    // If this time and the time parameter are closer than minimumTimeDiff, return false (There is a time conflict.)
+    // The distance wraps around midnight (e.g. 23:59:30 and 0:00:01 are 31 secs apart, not 86369.)
+    if (time.distance(schedule[i]) < minimumTimeDiff) {
       return false;
     }
   }
@@ -62,22 +70,18 @@ bool Schedule::checkTimeConflicts(uint8_t h, uint8_t m, uint8_t s, bool do_skip
 }
 
 // Adds a new time to the schedule if there is room. Returns true if successful.
-// Returns: 1 = success, 2 = failed (time conlflict), 0 = failed (bad index)
-uint8_t Schedule::addTime(uint8_t h, uint8_t m, uint8_t s) {
-  // validation
-  if (Schedule::count >= 12) {
+// Returns: 1 = success, 2 = failed (time conlflict), 0 = failed (no room, or bad time)
+uint8_t Schedule::addTime(uint8_t h, uint8_t m, uint8_t s, Recurrence rule) {
+  // validation (before the time is packed, which would carry e.g. 75 minutes into the hour)
+  if (Schedule::count >= maxTimes || !TimeValue::isValid(h, m, s) || !rule.isValid()) {
     return 0;
   }
   if (!Schedule::checkTimeConflicts(h, m, s)) {
     return 2;
   }
-  // Create a new time
-  TimeValue* newTime = new TimeValue();
-  newTime->hours = h;
-  newTime->minutes = m;
-  newTime->seconds = s;
   // Add time to the array
-  schedule[count] = *newTime;
+  schedule[count] = TimeValue(h, m, s);
+  rules[count] = rule;
   count++;
   // Sort the schedule.
   Schedule::sort();
@@ -85,19 +89,18 @@ uint8_t Schedule::addTime(uint8_t h, uint8_t m, uint8_t s) {
 }
 
 // Copies the H, M, S values from newTime to the time at position index.
-// Returns: 1 = success, 2 = failed (time conlflict), 0 = failed (bad index)
-uint8_t Schedule::updateTime(uint8_t index, uint8_t h, uint8_t m, uint8_t s) {
+// Returns: 1 = success, 2 = failed (time conlflict), 0 = failed (bad index or time)
+uint8_t Schedule::updateTime(uint8_t index, uint8_t h, uint8_t m, uint8_t s, Recurrence rule) {
   // validation
-  if (index < 0 || index >= Schedule::count) {
+  if (index >= Schedule::count || !TimeValue::isValid(h, m, s) || !rule.isValid()) {
     return 0;
   }
   if (!Schedule::checkTimeConflicts(h, m, s, true, index)) {
     return 2;
   }
   // Update the time at this index
-  schedule[index].hours = h;
-  schedule[index].minutes = m;
-  schedule[index].seconds = s;
+  schedule[index] = TimeValue(h, m, s);
+  rules[index] = rule;
   // Sort the schedule.
   Schedule::sort();
   return 1;
@@ -109,24 +112,146 @@ bool Schedule::removeTime(uint8_t index) {
   if (count == 0 || index >= count) {
     return false;
   }
-  // remove time
-  TimeValue* newSchedule = new TimeValue[count - 1];
-  uint8_t idx = 0;
-  for (uint8_t i = 0; i < count; i++) {
-    if (i != index) {
-      newSchedule[idx] = schedule[i];
-      idx++;
-    }
+  // remove time by shifting the later times down one spot (keeps the array at full capacity)
+  for (uint8_t i = index; i < count - 1; i++) {
+    schedule[i] = schedule[i + 1];
+    rules[i] = rules[i + 1];
   }
-  delete[] schedule; // Free the old array
-  schedule = newSchedule;
   count--;
   // Sorting is not necessary
   return true;
 }
 
+// A time in the working copy of a batch, and which edit (if any) put it there.
+struct BatchEntry {
+  TimeValue time;
+  Recurrence rule;
+  uint8_t editIndex;
+};
+
+// qsort() comparison for BatchEntry, smallest time first.
+static int compareBatchEntries(const void* a, const void* b) {
+  TimeValue t1 = ((const BatchEntry*)a)->time;
+  TimeValue t2 = ((const BatchEntry*)b)->time;
+  return (t1 > t2) - (t1 < t2);
+}
+
+// Applies a batch of adds, updates and removes all at once. Either every edit is applied, or none are.
+// Time conflicts are checked in one sweep over the sorted result, so the batch costs a single sort
+// instead of a conflict check and sort per edit. With isSpacingChecked false, times closer together than
+// MinTimeDiff are let through (for restoring times that were checked when they were set).
+// `results` must hold editCount codes, and receives one per edit:
+// 1 = success, 2 = failed (time conflict), 0 = failed (bad index, bad time, or schedule is full)
+// Returns true if the batch was applied.
+bool Schedule::applyBatch(const ScheduleEdit* edits, uint8_t editCount, uint8_t* results, bool isSpacingChecked) {
+  const uint8_t noEdit = 255;
+  long minimumTimeDiff = Tunables::get(TunableId::MinTimeDiff); // The number of seconds apart all times must be at minimum.
+  uint8_t editAt[maxTimes]; // The update/remove edit for each existing time, if any.
+  BatchEntry working[maxTimes];
+  uint8_t n = 0;
+  bool isValid = true;
+
+  for (uint8_t i = 0; i < count; i++) {
+    editAt[i] = noEdit;
+  }
+  // Validate each edit on its own.
+  for (uint8_t e = 0; e < editCount; e++) {
+    results[e] = 1;
+    Recurrence rule = edits[e].rule;
+    if (edits[e].op != ScheduleEditOp::Remove && (!edits[e].time.isValid() || !rule.isValid())) {
+      results[e] = 0;
+      continue;
+    }
+    if (edits[e].op != ScheduleEditOp::Add) {
+      // Each existing time may only be updated or removed once per batch.
+      if (edits[e].index >= count || editAt[edits[e].index] != noEdit) {
+        results[e] = 0;
+        continue;
+      }
+      editAt[edits[e].index] = e;
+    }
+  }
+  // Build the schedule as it would be after the batch: kept and updated times first, then additions.
+  for (uint8_t i = 0; i < count; i++) {
+    if (editAt[i] == noEdit) {
+      working[n].time = schedule[i];
+      working[n].rule = rules[i];
+      working[n].editIndex = noEdit;
+      n++;
+    }
+    else if (edits[editAt[i]].op == ScheduleEditOp::Update) {
+      working[n].time = edits[editAt[i]].time;
+      working[n].rule = edits[editAt[i]].rule;
+      working[n].editIndex = editAt[i];
+      n++;
+    }
+  }
+  for (uint8_t e = 0; e < editCount; e++) {
+    if (edits[e].op != ScheduleEditOp::Add || results[e] != 1) {
+      continue;
+    }
+    if (n >= maxTimes) {
+      results[e] = 0; // Schedule is full
+      continue;
+    }
+    working[n].time = edits[e].time;
+    working[n].rule = edits[e].rule;
+    working[n].editIndex = e;
+    n++;
+  }
+  // Sort once, then check each pair of neighboring times (including the last and first times,
+  // which are neighbors across midnight).
+  qsort(working, n, sizeof(BatchEntry), compareBatchEntries);
+  for (uint8_t i = 0; isSpacingChecked && n > 1 && i < n; i++) {
+    uint8_t j = (i + 1) % n;
+    if (working[i].time.until(working[j].time) < minimumTimeDiff) {
+      if (working[i].editIndex != noEdit) results[working[i].editIndex] = 2;
+      if (working[j].editIndex != noEdit) results[working[j].editIndex] = 2;
+    }
+  }
+
+  for (uint8_t e = 0; e < editCount; e++) {
+    if (results[e] != 1) {
+      isValid = false;
+    }
+  }
+  if (!isValid) {
+    DEBUG_PRINTLN(Time, F("Schedule batch rejected."));
+    return false;
+  }
+  // Commit
+  for (uint8_t i = 0; i < n; i++) {
+    schedule[i] = working[i].time;
+    rules[i] = working[i].rule;
+  }
+  count = n;
+  DEBUG_PRINTLN(Time, F("Applied schedule batch, the schedule is now: "));
+  Schedule::printSchedule();
+  return true;
+}
 
 // Returns the count of times in the schedule
 uint8_t Schedule::getCount() {
   return count;
+}
+
+// Finds the first time in the schedule that occurs at or after `from` (# of seconds since 2000-01-01).
+// Returns when it occurs (# of seconds since 2000-01-01) and sets index to its position,
+// or returns -1 if no time in the schedule ever occurs.
+long Schedule::nextOccurrence(long from, uint8_t* index) {
+  long fromDay = from / 86400, fromSeconds = from % 86400;
+  long best = -1;
+  for (uint8_t i = 0; i < count; i++) {
+    long t = schedule[i].totalSeconds();
+    // The first day this time could occur on is today, or tomorrow if it has already passed today.
+    long day = t >= fromSeconds ? fromDay : fromDay + 1;
+    uint16_t wait = rules[i].daysUntil(day);
+    if (wait == Recurrence::never) continue;
+    long when = (day + wait) * 86400 + t;
+    if (best < 0 || when < best) {
+      best = when;
+      *index = i;
+    }
+  }
+  return best;
 }
\ No newline at end of file
@@ -3,20 +3,43 @@
 
 #include <Arduino.h> // Arduino code environment
 #include "TimeValue.h"
+#include "Recurrence.h"
+
+// The kinds of edits that can be made in a batch. See Schedule::applyBatch().
+enum class ScheduleEditOp : uint8_t {
+  Add = 0,
+  Update = 1,
+  Remove = 2
+};
+
+// A single edit in a batch. `index` refers to the schedule as it was before the batch (ignored for Add).
+struct ScheduleEdit {
+  ScheduleEditOp op;
+  uint8_t index;
+  TimeValue time;
+  Recurrence rule; // Zeroed = every day
+};
 
 class Schedule {
   protected:
     void sort();
+    void printSchedule();
     TimeValue* schedule;
+    Recurrence* rules; // The days each time repeats on
     uint8_t count;
     bool checkTimeConflicts(uint8_t h, uint8_t m, uint8_t s, bool do_skip, uint8_t skip_index);
   public: 
+    // The max number of times a schedule can hold.
+    static const uint8_t maxTimes = 12;
     Schedule();
     TimeValue getTime(uint8_t index);
-    uint8_t addTime(uint8_t h, uint8_t m, uint8_t s);
-    uint8_t updateTime(uint8_t index, uint8_t h, uint8_t m, uint8_t s);
+    Recurrence getRule(uint8_t index);
+    uint8_t addTime(uint8_t h, uint8_t m, uint8_t s, Recurrence rule = Recurrence::daily());
+    uint8_t updateTime(uint8_t index, uint8_t h, uint8_t m, uint8_t s, Recurrence rule = Recurrence::daily());
     bool removeTime(uint8_t index);
+    bool applyBatch(const ScheduleEdit* edits, uint8_t editCount, uint8_t* results, bool isSpacingChecked = true);
     uint8_t getCount();
+    long nextOccurrence(long from, uint8_t* index);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <Arduino.h> // Arduino code environment
+#include "ScheduleTimeline.h"
+#include "Schedule.h"
+
+ScheduleTimeline::ScheduleTimeline(uint8_t maxSchedules) {
+  heap = new TimelineEvent[maxSchedules];
+  size = 0;
+  schedules = nullptr;
+}
+
+// Moves the event at i down the heap until both of its children are due later than it.
+void ScheduleTimeline::siftDown(uint8_t i) {
+  while (true) {
+    uint8_t smallest = i;
+    uint8_t left = i * 2 + 1, right = i * 2 + 2;
+    if (left < size && heap[left].key < heap[smallest].key) smallest = left;
+    if (right < size && heap[right].key < heap[smallest].key) smallest = right;
+    if (smallest == i) return;
+    TimelineEvent tmp = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = tmp;
+    i = smallest;
+  }
+}
+
+// Rebuilds the timeline from `now` (# of seconds since 2000-01-01). Must be called again whenever
+// a schedule is changed or the system time is set.
+void ScheduleTimeline::rebuild(Schedule** scheduleList, uint8_t count, long now) {
+  schedules = scheduleList;
+  size = 0;
+  for (uint8_t id = 0; id < count; id++) {
+    heap[size].key = schedules[id]->nextOccurrence(now, &heap[size].index);
+    if (heap[size].key < 0) continue; // Nothing on this schedule ever occurs
+    heap[size].scheduleId = id;
+    size++;
+  }
+  for (int i = size / 2 - 1; i >= 0; i--) {
+    siftDown(i);
+  }
+}
+
+// Copies the next event on the timeline to e. Returns false if no schedule has a time that occurs.
+bool ScheduleTimeline::peek(TimelineEvent* e) {
+  if (size == 0) return false;
+  *e = heap[0];
+  return true;
+}
+
+// Moves past the next event: the next time due on its schedule takes its place in the timeline.
+void ScheduleTimeline::advance() {
+  if (size == 0) return;
+  // Times in a schedule are at least MinTimeDiff (1 s or more) apart, so no two are due in the same
+  // second, and the next one due is always after this one.
+  heap[0].key = schedules[heap[0].scheduleId]->nextOccurrence(heap[0].key + 1, &heap[0].index);
+  if (heap[0].key < 0) {
+    heap[0] = heap[--size]; // Nothing left on this schedule occurs
+  }
+  siftDown(0);
+}
\ No newline at end of file
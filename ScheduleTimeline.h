@@ -0,0 +1,30 @@
+#ifndef SCHEDULETIMELINE_H
+#define SCHEDULETIMELINE_H
+
+#include <Arduino.h> // Arduino code environment
+#include "Schedule.h"
+
+// The next time due on one schedule.
+struct TimelineEvent {
+  long key; // When the time is next due, in # of seconds since 2000-01-01.
+  uint8_t scheduleId;
+  uint8_t index; // Index of the time in its schedule.
+};
+
+// A merged, ordered view of the upcoming times across several schedules.
+// This is a min-heap over the next time due on each schedule (a k-way merge), so the
+// next time due on any schedule is found in O(1), and moving past it costs O(log k).
+class ScheduleTimeline {
+  protected:
+    TimelineEvent* heap;
+    uint8_t size;
+    Schedule** schedules;
+    void siftDown(uint8_t i);
+  public:
+    ScheduleTimeline(uint8_t maxSchedules);
+    void rebuild(Schedule** scheduleList, uint8_t count, long now);
+    bool peek(TimelineEvent* e);
+    void advance();
+};
+
+#endif
\ No newline at end of file
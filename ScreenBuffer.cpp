@@ -0,0 +1,80 @@
+#include "ScreenBuffer.h"
+#include <Arduino.h> // Arduino code environment
+#include "I2CBus.h"
+
+ScreenBuffer::ScreenBuffer(LcdDriver* display) {
+  this->display = display;
+  memset(cells, ' ', sizeof(cells)); // The LCD starts out blank
+  memset(drawn, 0, sizeof(drawn));
+  memset(changed, 0, sizeof(changed));
+  setCursor(0, 0);
+}
+
+void ScreenBuffer::clear() {
+  memset(drawn, 0, sizeof(drawn));
+  setCursor(0, 0);
+}
+
+void ScreenBuffer::setCursor(uint8_t col, uint8_t row) {
+  if (row >= rows || col >= cols) {
+    cursor = lineEnd = 0; // Off the screen, so nothing is written
+    return;
+  }
+  cursor = row * cols + col;
+  lineEnd = (row + 1) * cols;
+}
+
+size_t ScreenBuffer::write(uint8_t c) {
+  // Text past the end of a line is dropped, rather than wrapping onto another line like the LCD does.
+  if (cursor < lineEnd) {
+    setCell(cursor, c);
+    drawn[cursor / 8] |= 1 << (cursor % 8);
+    cursor++;
+  }
+  return 1;
+}
+
+void ScreenBuffer::setCell(uint8_t i, char c) {
+  if (cells[i] != c) {
+    cells[i] = c;
+    changed[i / 8] |= 1 << (i % 8);
+  }
+}
+
+bool ScreenBuffer::flush() {
+  // Cells not drawn on this screen are blank
+  for (uint8_t i = 0; i < rows * cols; i++) {
+    if (!(drawn[i / 8] & (1 << (i % 8)))) {
+      setCell(i, ' ');
+    }
+  }
+  // Each run of changed cells in a row (up to maxRun) is sent as one write, with the cursor move before it
+  uint8_t run[maxRun];
+  for (uint8_t row = 0; row < rows; row++) {
+    uint8_t col = 0;
+    while (col < cols) {
+      uint8_t i = row * cols + col;
+      if (!(changed[i / 8] & (1 << (i % 8)))) {
+        col++;
+        continue;
+      }
+      // The rest waits for a later pass of loop(), so the time read isn't held up
+      if (!I2CBus::hasBudget(I2CPriority::Display)) {
+        return false;
+      }
+      uint8_t start = col, n = 0;
+      for (; col < cols && n < maxRun && (changed[(row * cols + col) / 8] & (1 << ((row * cols + col) % 8))); col++) {
+        run[n++] = cells[row * cols + col];
+      }
+      display->setCursor(start, row);
+      if (display->write(run, n) != n) {
+        return false; // Not acknowledged, or the bus timed out: the run stays changed, to try again next time
+      }
+      for (uint8_t c = start; c < col; c++) {
+        i = row * cols + c;
+        changed[i / 8] &= ~(1 << (i % 8));
+      }
+    }
+  }
+  return true;
+}
\ No newline at end of file
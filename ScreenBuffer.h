@@ -0,0 +1,36 @@
+#ifndef SCREENBUFFER_H
+#define SCREENBUFFER_H
+
+#include <Arduino.h> // Arduino code environment
+#include "LcdDriver.h" // for the LCD
+
+// A copy of what is on the 20x4 LCD. A screen is drawn into it between clear() and flush(),
+// and flush() only sends the characters that changed, so a repaint costs as much as what it changes.
+// The LCD is never cleared; blank cells are overwritten with spaces instead.
+class ScreenBuffer : public Print {
+  public:
+    static const uint8_t cols = 20, rows = 4;
+    ScreenBuffer(LcdDriver* display);
+    // Starts drawing a new screen. Nothing is sent to the LCD.
+    void clear();
+    void setCursor(uint8_t col, uint8_t row);
+    size_t write(uint8_t c);
+    // Sends the changes since the last flush() to the LCD. Cells not drawn since clear() become blank.
+    // Stops when the display's share of the I2C bus is used up for this pass of loop(), and returns
+    // false; the next flush() sends the rest.
+    bool flush();
+  private:
+    LcdDriver* display;
+    char cells[rows * cols];
+    // One bit per cell: written since clear(), and different from the LCD
+    uint8_t drawn[rows * cols / 8], changed[rows * cols / 8];
+    // Where the next character goes, and the end of its line
+    uint8_t cursor, lineEnd;
+    // The most cells sent in one write. The display's bus budget per pass (I2CBus) is only checked
+    // between writes, so a pass can go over it by one write. At 100 kHz a cell takes ~0.38 ms on the bus,
+    // so 4 cells and the cursor move before them take ~1.9 ms, where a whole row would take ~8 ms.
+    static const uint8_t maxRun = 4;
+    void setCell(uint8_t i, char c);
+};
+
+#endif
\ No newline at end of file
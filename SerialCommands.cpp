@@ -0,0 +1,55 @@
+#include <Arduino.h> // Arduino code environment
+#include "SerialCommands.h"
+
+// TimeSync, Tunables and Trace
+const static uint8_t maxHandlers = 4;
+
+static char handlerLetters[maxHandlers];
+static CommandHandler handlers[maxHandlers];
+static uint8_t handlerCount;
+// The line being read. Long enough for the longest command ("s <M> <S>").
+static char line[28];
+static uint8_t lineLength;
+static bool isTooLong;
+
+static void SerialCommands::Init() {
+  handlerCount = 0;
+  lineLength = 0;
+  isTooLong = false;
+}
+
+static bool SerialCommands::subscribe(char letter, CommandHandler handler) {
+  if (handlerCount >= maxHandlers) {
+    return false;
+  }
+  handlerLetters[handlerCount] = letter;
+  handlers[handlerCount] = handler;
+  handlerCount++;
+  return true;
+}
+
+static void SerialCommands::Poll() {
+  // Nothing was compiled in that takes commands
+  if (handlerCount == 0) return;
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (lineLength < sizeof(line) - 1) {
+        line[lineLength++] = c;
+      }
+      else {
+        isTooLong = true;
+      }
+      continue;
+    }
+    line[lineLength] = '\0';
+    for (uint8_t i = 0; lineLength > 0 && !isTooLong && i < handlerCount; i++) {
+      if (handlerLetters[i] == line[0]) {
+        handlers[i](line);
+        break;
+      }
+    }
+    lineLength = 0;
+    isTooLong = false;
+  }
+}
\ No newline at end of file
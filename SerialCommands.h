@@ -0,0 +1,24 @@
+#ifndef SERIALCOMMANDS_H
+#define SERIALCOMMANDS_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Handles one command line, NUL-terminated and starting with its letter. Called as soon as the line
+// ends, so millis() is when it arrived.
+typedef void (*CommandHandler)(const char* line);
+
+// The one reader of Serial input. Reads a line at a time (ended by '\n' or '\r') and hands each line to
+// the handler registered for its first character, so each module (e.g. TimeSync 's', Tunables 'p',
+// Trace 't') only knows its own commands. Lines with no handler are dropped, and so are lines too
+// long for the buffer (rather than run cut short).
+class SerialCommands {
+  public:
+    static void Init();
+    // Calls handler for each line starting with letter. Returns false if there is no room for another.
+    static bool subscribe(char letter, CommandHandler handler);
+    // Reads what has arrived and runs the handlers of the lines it ends. To be called every pass of
+    // loop(), as TimeSync's timestamps are only as good as how soon a line is seen.
+    static void Poll();
+};
+
+#endif
\ No newline at end of file
@@ -1,27 +1,57 @@
 #include "SystemUI.h"
 #include <Arduino.h> // Arduino code environment
-#include <LiquidCrystal_I2C.h> // for the LCD
+#include "LcdDriver.h" // for the LCD
+#include "ScreenBuffer.h"
 #include "TimeValue.h"
 #include "TimeMgmt.h"
+#include "SystemUtil.h" // For the reset cause
+#include "MemoryMonitor.h"
+#include "FeedQueue.h"
+#include "I2CBus.h"
+#include "DoorMgmt.h" // For the jam stats and retries
+#include "Tunables.h"
 #include "Debug.h" // For debugging (could be removed)
 
 #pragma region State_Vars
-LiquidCrystal_I2C lcd(0x27, 20, 4);
+LcdDriver display(0x27, 20, 4);
+// Screens are drawn here, and only the changes are sent to the display.
+ScreenBuffer lcd(&display);
 UiState currentState;
 byte mainMenuCursorPos, scheduleMenuCursorPos, systemMenuCursorPos;
 byte timeSelectCursorPos, timeAdjustCursorPos;
+// The schedule (in TimeMgmt) being viewed/edited in the schedule menu.
+uint8_t selectedSchedule;
 bool debugEnabled;
 String version;
-TimeValue* currentTime;
-TimeValue* tmp_time;
+TimeValue currentTime;
+TimeValue tmp_time;
+// The repeat rule being entered for a schedule time
+Recurrence tmp_rule;
+byte repeatCursorPos;
+// The date being entered
+uint16_t tmp_year;
+uint8_t tmp_month, tmp_day;
+byte dateCursorPos;
+// The tunable shown in Settings, whether it's being changed, and the value being entered
+uint8_t settingsCursorPos;
+bool isEditingSetting;
+uint16_t tmp_setting;
+// Which page of System Info is shown
+byte sysInfoPage;
+// The doors whose jam message is up, by bit (door index)
+uint8_t jammedDoors;
+const static byte sysInfoPageCount = 4;
+// ms from reset until the UI took input
+unsigned long bootTime_ms;
 bool readyForReset, isPaused;
-uint8_t errorDelay;
+// Ends the message shown by SetText(), if it has a time limit
+TimerId textTimer;
 enum TimeInputFallback {
   SetScheduleTimes = 0,
   SetSysTime = 1
 };
-TimeInputFallback formPrevUi = 0;
-String timeInputHeader;
+TimeInputFallback formPrevUi = SetScheduleTimes;
+const __FlashStringHelper* timeInputHeader;
 // Up arrow custom character (8 row, 5 col pixels)
 byte upArrow[] = {
   B00000,
@@ -46,33 +76,53 @@ byte downArrow[] = {
 };
 #pragma endregion State_Vars
 
-static void SystemUI::Init(bool isDebugEnabled = false, String verNum) {
-  lcd.init();
-  lcd.backlight();
-  lcd.print("Initializing...");
+static void SystemUI::Init(bool isDebugEnabled, String verNum) {
+  display.init();
+  display.backlight();
+  lcd.print(F("Initializing..."));
+  lcd.flush();
   currentState = UiState::Home;
   mainMenuCursorPos = 0;
   scheduleMenuCursorPos = 0;
   systemMenuCursorPos = 0;
   timeSelectCursorPos = 0;
-  errorDelay = 0;
+  selectedSchedule = 0;
+  textTimer = Timers::none;
   readyForReset = false;
   isPaused = false;
-  tmp_time = new TimeValue();
-  lcd.createChar(0, upArrow);
-  lcd.createChar(1, downArrow);
+  sysInfoPage = 0;
+  jammedDoors = 0;
+  settingsCursorPos = 0;
+  isEditingSetting = false;
+  bootTime_ms = 0;
+  tmp_time = TimeValue();
+  // The RTC comes up after the UI, so show midnight until the first time update.
+  currentTime = TimeValue();
+  display.createChar(0, upArrow);
+  display.createChar(1, downArrow);
   version = verNum;
   debugEnabled = isDebugEnabled;
+  EventBus::subscribe(EventType::ButtonPressed, SystemUI::HandleEvent);
+  EventBus::subscribe(EventType::TimeChanged, SystemUI::HandleEvent);
+  EventBus::subscribe(EventType::DispenseStarted, SystemUI::HandleEvent);
+  EventBus::subscribe(EventType::DispenseDone, SystemUI::HandleEvent);
+  EventBus::subscribe(EventType::JamDetected, SystemUI::HandleEvent);
+  EventBus::subscribe(EventType::JamCleared, SystemUI::HandleEvent);
+  EventBus::subscribe(EventType::LowMemory, SystemUI::HandleEvent);
+  EventBus::subscribe(EventType::LightDrift, SystemUI::HandleEvent);
 }
 
 #pragma region Helper_Methods
 // Disables UI input and sets on-screen text to msg.
 // Use \n for multiple lines.
-// Accepts optional arg for amount of time, default 5 seconds. 
-// `timeDelay < 0` means message does not have a time limit.
-static void SystemUI::SetText(String msg, uint8_t timeDelay = 5) {
-  Debug::println("Setting UI text to: " + msg);
-  errorDelay = timeDelay;
+// Accepts optional arg for amount of time (ms), default 5 seconds. 
+// `time_ms == noTimeLimit` means message does not have a time limit.
+static void SystemUI::SetText(String msg, unsigned int time_ms = 5000) {
+  DEBUG_PRINTLN(Ui, "Setting UI text to: " + msg);
+  Timers::cancel(&textTimer);
+  if (time_ms != noTimeLimit) {
+    textTimer = Timers::start(time_ms, SystemUI::onTextTimer);
+  }
   lcd.clear();
   uint8_t line = 0;
   // Iterate char by char in msg
@@ -89,18 +139,23 @@ static void SystemUI::SetText(String msg, uint8_t timeDelay = 5) {
       lcd.print(msg[i]);
     }
   }
+  lcd.flush();
   // Disable UI Input
   PauseUi();
 }
 
-static void SystemUI::UpdateTime(TimeValue* newValue) {
-  if (newValue->isValid()) {
-    delete currentTime; // Delete deallocates the memory the pointer points to.
+static void SystemUI::UpdateTime(TimeValue newValue) {
+  if (newValue.isValid()) {
     currentTime = newValue;
-    Debug::println("Time: " + String(currentTime->toString()));
+    DEBUG_PRINTLN(Ui, "Time: " + currentTime.toString());
   }
 }
 
+static void SystemUI::SetBootTime(unsigned long ms) {
+  bootTime_ms = ms;
+  DEBUG_PRINTLN(Ui, "UI ready in " + String(ms) + " ms");
+}
+
 // Returns true if user has inputted ready for system reset.
 static bool SystemUI::IsResetReady() {
   return readyForReset;
@@ -112,30 +167,92 @@ static bool SystemUI::IsUiPaused() {
 // Setter for pausing the UI.
 static void SystemUI::PauseUi() {
   isPaused = true;
-  Debug::println("Pausing UI");
+  DEBUG_PRINTLN(Ui, F("Pausing UI"));
 }
 // Setter for unpausing the UI.
 static void SystemUI::UnpauseUi() {
   isPaused = false;
-  Debug::println("Unpausing UI");
+  DEBUG_PRINTLN(Ui, F("Unpausing UI"));
 }
 
-static bool SystemUI::ErrorTick() {
-  if (errorDelay > 0) {
-    errorDelay--;
-    if (errorDelay == 0) {
-      return true;
-    }
-  }
-  return false;
+static void SystemUI::onTextTimer(uint8_t) {
+  textTimer = Timers::none;
+  SystemUI::UnpauseUi();
+  SystemUI::UpdateUI();
+}
+
+static void SystemUI::FlushTick() {
+  lcd.flush();
 }
 
 static void SystemUI::ClearError() {
-  errorDelay = 0;
+  jammedDoors = 0;
+  Timers::cancel(&textTimer);
   SystemUI::UnpauseUi();
   SystemUI::UpdateUI();
 }
 
+static void SystemUI::HandleEvent(Event e) {
+  switch (e.type) {
+    case EventType::ButtonPressed:
+      SystemUI::Input((UiButton)e.arg);
+      SystemUI::UpdateUI();
+      break;
+    case EventType::TimeChanged:
+      // sync currentTime with the current time from timeMgmt
+      SystemUI::UpdateTime(TimeMgmt::getLastTime());
+      if (SystemUI::IsTimeNeeded()) {
+        SystemUI::UpdateUI();
+      }
+      break;
+    case EventType::DispenseStarted:
+      // Feedings that came due while the door was busy run right after this one
+      if (FeedQueue::getDepth() > 0) {
+        SystemUI::SetText(String(F("Dispensing food.\n")) + String(FeedQueue::getDepth()) + F(" more queued."), noTimeLimit);
+      }
+      else {
+        SystemUI::SetText(F("Dispensing food."), noTimeLimit);
+      }
+      break;
+    case EventType::DispenseDone:
+      SystemUI::UnpauseUi();
+      SystemUI::UpdateUI();
+      break;
+    case EventType::JamDetected: {
+      // Message is cleared when jam is resolved. The operator is only asked to step in once the
+      // automatic retries have run out.
+      jammedDoors |= 1 << e.arg;
+      uint8_t retries = DoorMgmt::getRetryCount(e.arg);
+      uint8_t maxRetries = Tunables::get(TunableId::JamRetries);
+      if (retries < maxRetries) {
+        SystemUI::SetText(String(F("[Error] Door ")) + String(e.arg + 1) + F("\nJam detected.\nRetrying (")
+          + String(retries + 1) + F("/") + String(maxRetries) + F(")..."), noTimeLimit);
+      }
+      else {
+        SystemUI::SetText(String(F("[Error] Door ")) + String(e.arg + 1) + F("\nJam detected.\nRemove jam, then\npress OK to resume."), noTimeLimit);
+      }
+      break;
+    }
+    case EventType::JamCleared:
+      jammedDoors &= ~(1 << e.arg);
+      SystemUI::SetText(F("Dispensing food."), 2000);
+      break;
+    // Warnings don't replace a jam message, which is what needs seeing to.
+    case EventType::LowMemory:
+      if (jammedDoors == 0) {
+        SystemUI::SetText(String(F("[Warning]\nLow memory.\n")) + String(e.arg) + F(" bytes free."));
+      }
+      break;
+    case EventType::LightDrift:
+      if (jammedDoors == 0) {
+        SystemUI::SetText(String(F("[Warning] Door ")) + String(e.arg + 1) + F("\nLight sensor drift.\nClean the sensor."));
+      }
+      break;
+    default:
+      break;
+  }
+}
+
 static bool SystemUI::IsTimeNeeded() {
   switch (currentState) { 
     // Current time is displayed on these UI screens:
@@ -143,8 +260,9 @@ static bool SystemUI::IsTimeNeeded() {
     case UiState::SetTime:
     case UiState::SystemInfo:
       return true;
+    default:
+      return false;
   }
-  return false;
 }
 #pragma endregion Helper_Methods
 
@@ -187,6 +305,15 @@ static void SystemUI::Input(UiButton i) {
     case UiState::TimeInput:
       SystemUI::TimeInputUi(i);
       break;
+    case UiState::RepeatInput:
+      SystemUI::RepeatInputUi(i);
+      break;
+    case UiState::SetDate:
+      SystemUI::SetDateUi(i);
+      break;
+    case UiState::Settings:
+      SystemUI::SettingsUi(i);
+      break;
   }
 }
 static void SystemUI::HomeUi(UiButton i) {
@@ -234,10 +361,10 @@ static void SystemUI::MenuUi(UiButton i) {
 static void SystemUI::ScheduleMenuUi(UiButton i) {
   switch (i) {
     case UiButton::Up:
-      scheduleMenuCursorPos = (scheduleMenuCursorPos + 3) % 4;
+      scheduleMenuCursorPos = (scheduleMenuCursorPos + 4) % 5;
       break;
     case UiButton::Down:
-      scheduleMenuCursorPos = (scheduleMenuCursorPos + 1) % 4;
+      scheduleMenuCursorPos = (scheduleMenuCursorPos + 1) % 5;
       break;
     case UiButton::OK:
       timeSelectCursorPos = 0; // Reset this position regardless
@@ -252,6 +379,10 @@ static void SystemUI::ScheduleMenuUi(UiButton i) {
           currentState = UiState::RemoveTimes;
           break;
         case 3:
+          // Switch to the next schedule
+          selectedSchedule = (selectedSchedule + 1) % TimeMgmt::getScheduleCount();
+          break;
+        case 4:
           currentState = UiState::Menu;
           break;
       }
@@ -264,10 +395,10 @@ static void SystemUI::ScheduleMenuUi(UiButton i) {
 static void SystemUI::SysMenuUi(UiButton i) {
   switch (i) {
     case UiButton::Up:
-      systemMenuCursorPos = (systemMenuCursorPos + 3) % 4;
+      systemMenuCursorPos = (systemMenuCursorPos + 5) % 6;
       break;
     case UiButton::Down:
-      systemMenuCursorPos = (systemMenuCursorPos + 1) % 4;
+      systemMenuCursorPos = (systemMenuCursorPos + 1) % 6;
       break;
     case UiButton::OK:
       switch (systemMenuCursorPos) {
@@ -276,12 +407,24 @@ static void SystemUI::SysMenuUi(UiButton i) {
           currentState = UiState::SetTime;
           break;
         case 1:
-          currentState = UiState::SystemInfo;
+          dateCursorPos = 0;
+          tmp_year = TimeMgmt::getYear();
+          tmp_month = TimeMgmt::getMonth();
+          tmp_day = TimeMgmt::getDay();
+          currentState = UiState::SetDate;
           break;
         case 2:
-          currentState = UiState::Reset;
+          currentState = UiState::SystemInfo;
           break;
         case 3:
+          settingsCursorPos = 0;
+          isEditingSetting = false;
+          currentState = UiState::Settings;
+          break;
+        case 4:
+          currentState = UiState::Reset;
+          break;
+        case 5:
           currentState = UiState::Menu;
           break;
       }
@@ -292,7 +435,7 @@ static void SystemUI::SysMenuUi(UiButton i) {
   }
 }
 static void SystemUI::ViewTimesUi(UiButton i) {
-  uint8_t scheduleSize = TimeMgmt::getScheduleSize();
+  uint8_t scheduleSize = TimeMgmt::getScheduleSize(selectedSchedule);
   switch (i) {
     case UiButton::Up:
       if (timeSelectCursorPos > 0) {
@@ -317,7 +460,7 @@ static void SystemUI::ViewTimesUi(UiButton i) {
   }
 }
 static void SystemUI::SetTimesUi(UiButton i) {
-  uint8_t scheduleSize = TimeMgmt::getScheduleSize();
+  uint8_t scheduleSize = TimeMgmt::getScheduleSize(selectedSchedule);
   switch (i) {
     case UiButton::Up:
       if (timeSelectCursorPos != 0) {
@@ -336,17 +479,14 @@ static void SystemUI::SetTimesUi(UiButton i) {
     case UiButton::OK:
       // The timeSelectCursorPos will be used to determine what times to populate
       if (timeSelectCursorPos == scheduleSize) {
-        timeInputHeader = "[Add Time]";
-        tmp_time->hours = 0;
-        tmp_time->minutes = 0;
-        tmp_time->seconds = 0;
+        timeInputHeader = F("[Add Time]");
+        tmp_time = TimeValue();
+        tmp_rule = Recurrence::daily();
       }
       else {
-        timeInputHeader = "[Update Time]";
-        TimeValue t = TimeMgmt::getScheduleTime(timeSelectCursorPos);
-        tmp_time->hours = t.hours;
-        tmp_time->minutes = t.minutes;
-        tmp_time->seconds = t.seconds;
+        timeInputHeader = F("[Update Time]");
+        tmp_time = TimeMgmt::getScheduleTime(selectedSchedule, timeSelectCursorPos);
+        tmp_rule = TimeMgmt::getScheduleRule(selectedSchedule, timeSelectCursorPos);
       }
       timeAdjustCursorPos = 0;
       formPrevUi = TimeInputFallback::SetScheduleTimes;
@@ -358,7 +498,7 @@ static void SystemUI::SetTimesUi(UiButton i) {
   }
 }
 static void SystemUI::RemoveTimesUi(UiButton i) {
-  uint8_t scheduleSize = TimeMgmt::getScheduleSize();
+  uint8_t scheduleSize = TimeMgmt::getScheduleSize(selectedSchedule);
   switch (i) {
     case UiButton::Up:
       if (timeSelectCursorPos > 0) {
@@ -372,7 +512,7 @@ static void SystemUI::RemoveTimesUi(UiButton i) {
       }
       break;
     case UiButton::OK:
-      TimeMgmt::removeScheduleTime(timeSelectCursorPos);
+      TimeMgmt::removeScheduleTime(selectedSchedule, timeSelectCursorPos);
       timeSelectCursorPos = 0;
       break;
     case UiButton::Menu:
@@ -391,10 +531,8 @@ static void SystemUI::SetSysTimeUi(UiButton i) {
     case UiButton::OK:
       timeAdjustCursorPos = 0;
       formPrevUi = TimeInputFallback::SetSysTime;
-      timeInputHeader = "[Set System Time]";
-      tmp_time->hours = TimeMgmt::getHours();
-      tmp_time->minutes = TimeMgmt::getMinutes();
-      tmp_time->seconds = TimeMgmt::getSeconds();
+      timeInputHeader = F("[Set System Time]");
+      tmp_time = TimeValue(TimeMgmt::getHours(), TimeMgmt::getMinutes(), TimeMgmt::getSeconds());
       currentState = UiState::TimeInput;
       break;
     case UiButton::Menu:
@@ -405,15 +543,17 @@ static void SystemUI::SetSysTimeUi(UiButton i) {
 static void SystemUI::SysInfoUi(UiButton i) {
   switch (i) {
     case UiButton::Up:
-      // Do nothing
+      sysInfoPage = (sysInfoPage + sysInfoPageCount - 1) % sysInfoPageCount;
       break;
     case UiButton::Down:
-      // Do nothing
+      sysInfoPage = (sysInfoPage + 1) % sysInfoPageCount;
       break;
     case UiButton::OK:
+      sysInfoPage = 0;
       currentState = UiState::SystemMenu;
       break;
     case UiButton::Menu:
+      sysInfoPage = 0;
       currentState = UiState::SystemMenu;
       break;
   }
@@ -447,33 +587,33 @@ static void SystemUI::TimeInputUi(UiButton i) {
       switch (timeAdjustCursorPos) {
         case 0:
           // Hour 1st digit
-          tmp_h = tmp_time->hours;
-          tmp_time->hours = tmp_h % 10 + (((tmp_h / 10) + 1) % 3) * 10;
+          tmp_h = tmp_time.getHours();
+          tmp_time.setHours(tmp_h % 10 + (((tmp_h / 10) + 1) % 3) * 10);
           break;
         case 1:
           // Hour 2nd digit
-          tmp_h = tmp_time->hours;
-          tmp_time->hours = (tmp_h / 10) * 10 + (tmp_h + 1) % (tmp_h >= 20 ? 4 : 10);
+          tmp_h = tmp_time.getHours();
+          tmp_time.setHours((tmp_h / 10) * 10 + (tmp_h + 1) % (tmp_h >= 20 ? 4 : 10));
           break;
         case 2:
           // Minute 1st digit
-          tmp_m = tmp_time->minutes;
-          tmp_time->minutes = tmp_m % 10 + (((tmp_m / 10) + 1) % 6) * 10;
+          tmp_m = tmp_time.getMinutes();
+          tmp_time.setMinutes(tmp_m % 10 + (((tmp_m / 10) + 1) % 6) * 10);
           break;
         case 3:
           // Minute 2nd digit
-          tmp_m = tmp_time->minutes;
-          tmp_time->minutes = (tmp_m / 10) * 10 + (tmp_m + 1) % 10;
+          tmp_m = tmp_time.getMinutes();
+          tmp_time.setMinutes((tmp_m / 10) * 10 + (tmp_m + 1) % 10);
           break;
         case 4:
           // Second 1st digit
-          tmp_s = tmp_time->seconds;
-          tmp_time->seconds = tmp_s % 10 + (((tmp_s / 10) + 1) % 6) * 10;
+          tmp_s = tmp_time.getSeconds();
+          tmp_time.setSeconds(tmp_s % 10 + (((tmp_s / 10) + 1) % 6) * 10);
           break;
         case 5:
           // Second 2nd digit
-          tmp_s = tmp_time->seconds;
-          tmp_time->seconds = (tmp_s / 10) * 10 + (tmp_s + 1) % 10;
+          tmp_s = tmp_time.getSeconds();
+          tmp_time.setSeconds((tmp_s / 10) * 10 + (tmp_s + 1) % 10);
           break;
       }
       break;
@@ -483,33 +623,33 @@ static void SystemUI::TimeInputUi(UiButton i) {
       switch (timeAdjustCursorPos) {
         case 0:
           // Hour 1st digit
-          tmp_h = tmp_time->hours;
-          tmp_time->hours = tmp_h % 10 + (((tmp_h / 10) + 2) % 3) * 10;
+          tmp_h = tmp_time.getHours();
+          tmp_time.setHours(tmp_h % 10 + (((tmp_h / 10) + 2) % 3) * 10);
           break;
         case 1:
           // Hour 2nd digit
-          tmp_h = tmp_time->hours;
-          tmp_time->hours = (tmp_h / 10) * 10 + (tmp_h + (tmp_h >= 20 ? 3 : 9)) % (tmp_h >= 20 ? 4 : 10);
+          tmp_h = tmp_time.getHours();
+          tmp_time.setHours((tmp_h / 10) * 10 + (tmp_h + (tmp_h >= 20 ? 3 : 9)) % (tmp_h >= 20 ? 4 : 10));
           break;
         case 2:
           // Minute 1st digit
-          tmp_m = tmp_time->minutes;
-          tmp_time->minutes = tmp_m % 10 + (((tmp_m / 10) + 5) % 6) * 10;
+          tmp_m = tmp_time.getMinutes();
+          tmp_time.setMinutes(tmp_m % 10 + (((tmp_m / 10) + 5) % 6) * 10);
           break;
         case 3:
           // Minute 2nd digit
-          tmp_m = tmp_time->minutes;
-          tmp_time->minutes = (tmp_m / 10) * 10 + (tmp_m + 9) % 10;
+          tmp_m = tmp_time.getMinutes();
+          tmp_time.setMinutes((tmp_m / 10) * 10 + (tmp_m + 9) % 10);
           break;
         case 4:
           // Second 1st digit
-          tmp_s = tmp_time->seconds;
-          tmp_time->seconds = tmp_s % 10 + (((tmp_s / 10) + 5) % 6) * 10;
+          tmp_s = tmp_time.getSeconds();
+          tmp_time.setSeconds(tmp_s % 10 + (((tmp_s / 10) + 5) % 6) * 10);
           break;
         case 5:
           // Second 2nd digit
-          tmp_s = tmp_time->seconds;
-          tmp_time->seconds = (tmp_s / 10) * 10 + (tmp_s + 9) % 10;
+          tmp_s = tmp_time.getSeconds();
+          tmp_time.setSeconds((tmp_s / 10) * 10 + (tmp_s + 9) % 10);
           break;
       }
       break;
@@ -518,26 +658,21 @@ static void SystemUI::TimeInputUi(UiButton i) {
         timeAdjustCursorPos++;
 
         // Special case: if 2 is input for first hour digit (hr >= 20), the second hour digit must be <= 3
-        if (timeAdjustCursorPos == 1 && tmp_time->hours > 20 && tmp_time->hours % 10 > 3) {
-          tmp_time->hours = 23;
+        if (timeAdjustCursorPos == 1 && tmp_time.getHours() > 20 && tmp_time.getHours() % 10 > 3) {
+          tmp_time.setHours(23);
         }
       }
       else {
         if (formPrevUi == TimeInputFallback::SetScheduleTimes) {
-          // Update a schedule time (wherever the timeSelectCursorPos is valued at)
-          uint8_t response = TimeMgmt::setScheduleTime(timeSelectCursorPos, tmp_time->hours, tmp_time->minutes, tmp_time->seconds);
-          if (response != 1) {
-            Debug::print("Set Schedule Error: ");
-            Debug::println(String(response));
-            SystemUI::SetText("[Error]\nFailed to set time.\nTimes must be apart\nby 60s or more.", 5);
-          }
-          currentState = UiState::SetTimes;
+          // Next, choose the days this time repeats on
+          repeatCursorPos = 0;
+          currentState = UiState::RepeatInput;
         }
         else if (formPrevUi == TimeInputFallback::SetSysTime) {
           // Update system time
-          TimeMgmt::setHours(tmp_time->hours);
-          TimeMgmt::setMinutes(tmp_time->minutes);
-          TimeMgmt::setSeconds(tmp_time->seconds);
+          TimeMgmt::setHours(tmp_time.getHours());
+          TimeMgmt::setMinutes(tmp_time.getMinutes());
+          TimeMgmt::setSeconds(tmp_time.getSeconds());
           currentState = UiState::SetTime;
         }
       }
@@ -554,6 +689,141 @@ static void SystemUI::TimeInputUi(UiButton i) {
       break;
   }
 }
+static void SystemUI::RepeatInputUi(UiButton i) {
+  // Cursor vals: 0 - 6 = weekdays (Sunday first), 7 = every N days
+  switch (i) {
+    case UiButton::Up:
+    case UiButton::Down:
+      if (repeatCursorPos < 7) {
+        // Toggle the weekday (switching back to weekdays from every N days starts from every day)
+        uint8_t mask = tmp_rule.isInterval() ? B1111111 : tmp_rule.getWeekdays();
+        tmp_rule = Recurrence::weekly(mask ^ (1 << repeatCursorPos));
+      }
+      else {
+        // Change N. N = 0 switches back to weekdays.
+        uint8_t n = tmp_rule.getInterval();
+        n = (i == UiButton::Up) ? (n + 1) % 100 : (n + 99) % 100;
+        tmp_rule = (n == 0) ? Recurrence::daily() : Recurrence::everyNDays(n, TimeMgmt::getDayNumber());
+      }
+      break;
+    case UiButton::OK:
+      if (repeatCursorPos != 7) {
+        repeatCursorPos++;
+      }
+      else {
+        // Update a schedule time (wherever the timeSelectCursorPos is valued at)
+        uint8_t response = TimeMgmt::setScheduleTime(selectedSchedule, timeSelectCursorPos, tmp_time.getHours(), tmp_time.getMinutes(), tmp_time.getSeconds(), tmp_rule);
+        if (response != 1) {
+          DEBUG_PRINT(Ui, F("Set Schedule Error: "));
+          DEBUG_PRINTLN(Ui, String(response));
+          if (!tmp_rule.isValid()) {
+            SystemUI::SetText(F("[Error]\nFailed to set time.\nPick at least one\nday to repeat on."), 5000);
+          }
+          else {
+            SystemUI::SetText(String(F("[Error]\nFailed to set time.\nTimes must be apart\nby ")) + String(Tunables::get(TunableId::MinTimeDiff)) + F("s or more."), 5000);
+          }
+        }
+        currentState = UiState::SetTimes;
+      }
+      break;
+    case UiButton::Menu:
+      // Back to the time
+      currentState = UiState::TimeInput;
+      break;
+  }
+}
+static void SystemUI::SetDateUi(UiButton i) {
+  const static uint8_t daysInMonth[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  uint8_t monthDays = daysInMonth[tmp_month - 1];
+  if (tmp_month == 2 && tmp_year % 4 != 0) {
+    monthDays = 28;
+  }
+  // Cursor vals: 0 = year, 1 = month, 2 = day
+  switch (i) {
+    case UiButton::Up:
+      switch (dateCursorPos) {
+        case 0:
+          tmp_year = 2000 + (tmp_year - 2000 + 1) % 100;
+          break;
+        case 1:
+          tmp_month = tmp_month % 12 + 1;
+          break;
+        case 2:
+          tmp_day = tmp_day % monthDays + 1;
+          break;
+      }
+      break;
+    case UiButton::Down:
+      switch (dateCursorPos) {
+        case 0:
+          tmp_year = 2000 + (tmp_year - 2000 + 99) % 100;
+          break;
+        case 1:
+          tmp_month = (tmp_month + 10) % 12 + 1;
+          break;
+        case 2:
+          tmp_day = (tmp_day + monthDays - 2) % monthDays + 1;
+          break;
+      }
+      break;
+    case UiButton::OK:
+      if (dateCursorPos != 2) {
+        dateCursorPos++;
+        // The day may no longer fit in the chosen month
+        if (dateCursorPos == 2 && tmp_day > monthDays) {
+          tmp_day = monthDays;
+        }
+      }
+      else {
+        TimeMgmt::setDate(tmp_year, tmp_month, tmp_day);
+        currentState = UiState::SystemMenu;
+      }
+      break;
+    case UiButton::Menu:
+      currentState = UiState::SystemMenu;
+      break;
+  }
+}
+static void SystemUI::SettingsUi(UiButton i) {
+  const uint8_t count = (uint8_t)TunableId::Count;
+  TunableInfo info;
+  Tunables::getInfo((TunableId)settingsCursorPos, &info);
+  // Browsing: Up/Down pick a tunable, OK starts changing it
+  if (!isEditingSetting) {
+    switch (i) {
+      case UiButton::Up:
+        settingsCursorPos = (settingsCursorPos + count - 1) % count;
+        break;
+      case UiButton::Down:
+        settingsCursorPos = (settingsCursorPos + 1) % count;
+        break;
+      case UiButton::OK:
+        tmp_setting = Tunables::get((TunableId)settingsCursorPos);
+        isEditingSetting = true;
+        break;
+      case UiButton::Menu:
+        currentState = UiState::SystemMenu;
+        break;
+    }
+    return;
+  }
+  // Changing: Up/Down change the value by its step (hold to repeat), OK saves, Menu cancels
+  switch (i) {
+    case UiButton::Up:
+      tmp_setting = info.max - tmp_setting < info.step ? info.max : tmp_setting + info.step;
+      break;
+    case UiButton::Down:
+      tmp_setting = tmp_setting - info.min < info.step ? info.min : tmp_setting - info.step;
+      break;
+    case UiButton::OK:
+      Tunables::set((TunableId)settingsCursorPos, tmp_setting);
+      isEditingSetting = false;
+      break;
+    case UiButton::Menu:
+      isEditingSetting = false;
+      break;
+  }
+}
 #pragma endregion Input_Handler_Methods
 
 #pragma region LCD_Printing_Methods
@@ -561,9 +831,8 @@ static void SystemUI::UpdateUI() {
   // if the UI is paused, do nothing (early return)
   if (isPaused) return;
   // Otherwise,
-  // Clear the current text from the screen.
+  // Start a new screen (only what changes from the current one is sent to the display)
   lcd.clear();
-  lcd.setCursor(0, 0);
   // Depending on the currentState and variables, print certain text out.
   switch (currentState) {
     case UiState::Home:
@@ -599,51 +868,79 @@ static void SystemUI::UpdateUI() {
     case UiState::TimeInput:
       SystemUI::PrintTimeInputUi();
       break;
+    case UiState::RepeatInput:
+      SystemUI::PrintRepeatInputUi();
+      break;
+    case UiState::SetDate:
+      SystemUI::PrintSetDateUi();
+      break;
+    case UiState::Settings:
+      SystemUI::PrintSettingsUi();
+      break;
   }
+  lcd.flush();
 }
 
 static void SystemUI::PrintHomeUi() {
-  lcd.print("Home");
+  uint8_t sched;
+  TimeValue next;
+  lcd.print(F("Home"));
   lcd.setCursor(0, 1);
-  lcd.print(currentTime->toString());
+  lcd.print(currentTime.toString());
+  // Print the next feeding across all schedules
+  if (TimeMgmt::getNextFeeding(&sched, &next)) {
+    lcd.setCursor(0, 2);
+    lcd.print(F("Next "));
+    lcd.print(next.toString());
+    lcd.print(' ');
+    lcd.print(TimeMgmt::getScheduleName(sched));
+  }
+  // Feedings waiting on a busy or jammed door
+  if (FeedQueue::getDepth() > 0) {
+    lcd.setCursor(0, 3);
+    lcd.print(F("Queued feedings: "));
+    lcd.print(FeedQueue::getDepth());
+  }
 }
 static void SystemUI::PrintMenuUi() {
-  lcd.print("[Main Menu]");
+  lcd.print(F("[Main Menu]"));
   lcd.setCursor(0, 1);
-  lcd.print("Schedule Menu");
+  lcd.print(F("Schedule Menu"));
   if (mainMenuCursorPos == 0) {
-    lcd.print(" <");
+    lcd.print(F(" <"));
   }
   lcd.setCursor(0, 2);
-  lcd.print("System Menu");
+  lcd.print(F("System Menu"));
   if (mainMenuCursorPos == 1) {
-    lcd.print(" <");
+    lcd.print(F(" <"));
   }
   lcd.setCursor(0, 3);
-  lcd.print("Back");
+  lcd.print(F("Back"));
   if (mainMenuCursorPos == 2) {
-    lcd.print(" <");
+    lcd.print(F(" <"));
   }
 }
 static void SystemUI::PrintScheduleMenuUi() {
-  lcd.print("[Schedule Menu]");
-  // This menu has 4 choices, but only 3 can fit on a page.
+  lcd.print(F("[Schedule: "));
+  lcd.print(TimeMgmt::getScheduleName(selectedSchedule));
+  lcd.print(F("]"));
+  // This menu has 6 choices, but only 3 can fit on a page.
   // Page 1
   if (scheduleMenuCursorPos < 3) {
     lcd.setCursor(0, 1);
-    lcd.print("View times");
+    lcd.print(F("View times"));
     if (scheduleMenuCursorPos == 0) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
     }
     lcd.setCursor(0, 2);
-    lcd.print("Set times");
+    lcd.print(F("Set times"));
     if (scheduleMenuCursorPos == 1) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
     }
     lcd.setCursor(0, 3);
-    lcd.print("Remove times");
+    lcd.print(F("Remove times"));
     if (scheduleMenuCursorPos == 2) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
     }
     lcd.setCursor(19, 3);
     lcd.write(1);
@@ -651,33 +948,38 @@ static void SystemUI::PrintScheduleMenuUi() {
   // Page 2
   else {
     lcd.setCursor(0, 1);
-    lcd.print("Back");
+    lcd.print(F("Next schedule"));
     if (scheduleMenuCursorPos == 3) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
+    }
+    lcd.setCursor(0, 2);
+    lcd.print(F("Back"));
+    if (scheduleMenuCursorPos == 4) {
+      lcd.print(F(" <"));
     }
     lcd.setCursor(19, 1);
     lcd.write(0);
   }
 }
 static void SystemUI::PrintSysMenuUi() {
-  lcd.print("[System Menu]");
-  // This menu has 4 choices, but only 3 can fit on a page.
+  lcd.print(F("[System Menu]"));
+  // This menu has 6 choices, but only 3 can fit on a page.
   // Page 1
   if (systemMenuCursorPos < 3) {
     lcd.setCursor(0, 1);
-    lcd.print("Set time");
+    lcd.print(F("Set time"));
     if (systemMenuCursorPos == 0) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
     }
     lcd.setCursor(0, 2);
-    lcd.print("System info");
+    lcd.print(F("Set date"));
     if (systemMenuCursorPos == 1) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
     }
     lcd.setCursor(0, 3);
-    lcd.print("Reset");
+    lcd.print(F("System info"));
     if (systemMenuCursorPos == 2) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
     }
     lcd.setCursor(19, 3);
     lcd.write(1);
@@ -685,31 +987,46 @@ static void SystemUI::PrintSysMenuUi() {
   // Page 2
   else {
     lcd.setCursor(0, 1);
-    lcd.print("Back");
+    lcd.print(F("Settings"));
     if (systemMenuCursorPos == 3) {
-      lcd.print(" <");
+      lcd.print(F(" <"));
+    }
+    lcd.setCursor(0, 2);
+    lcd.print(F("Reset"));
+    if (systemMenuCursorPos == 4) {
+      lcd.print(F(" <"));
+    }
+    lcd.setCursor(0, 3);
+    lcd.print(F("Back"));
+    if (systemMenuCursorPos == 5) {
+      lcd.print(F(" <"));
     }
     lcd.setCursor(19, 1);
     lcd.write(0);
   }
 }
 static void SystemUI::PrintViewTimesUi() {
-  lcd.print("[View Times]");
-  uint8_t s = TimeMgmt::getScheduleSize();
+  lcd.print(F("[View Times]"));
+  uint8_t s = TimeMgmt::getScheduleSize(selectedSchedule);
   if (s == 0) {
     lcd.setCursor(0, 1);
-    lcd.print("Schedule is empty.");
+    lcd.print(F("Schedule is empty."));
     return; // Early return.
   } // Else, schedule has nonzero # of times, so print/paginate them
   uint8_t group = timeSelectCursorPos / 3;
   uint8_t group_start_idx = group * 3;
   uint8_t cursor = 1;
+  // Print page/group number (in the header, to leave room for the repeat days)
+  lcd.print(F(" Pg "));
+  lcd.print(group + 1);
   for (int i = group_start_idx; i < group_start_idx + 3; i++) {
     if (i < s) {
       lcd.setCursor(0, cursor);
-      lcd.print(TimeMgmt::getScheduleTime(i).toString());
+      lcd.print(TimeMgmt::getScheduleTime(selectedSchedule, i).toString());
+      lcd.print(F(" "));
+      lcd.print(TimeMgmt::getScheduleRule(selectedSchedule, i).toString());
       if (i == timeSelectCursorPos) {
-        lcd.print(" <");
+        lcd.print(F(" <"));
       }
       cursor++;
     }
@@ -727,32 +1044,27 @@ static void SystemUI::PrintViewTimesUi() {
     lcd.setCursor(19, 1);
     lcd.write(0);
   }
-  // Print page/group number
-  lcd.setCursor(16, 2);
-  lcd.print("Pg ");
-  lcd.print(group + 1);
-  
 }
 static void SystemUI::PrintSetTimesUi() {
-  lcd.print("[Set Times]");
-  uint8_t s = TimeMgmt::getScheduleSize();
+  lcd.print(F("[Set Times]"));
+  uint8_t s = TimeMgmt::getScheduleSize(selectedSchedule);
   uint8_t cursor = 1;
   uint8_t group = timeSelectCursorPos / 3;
   uint8_t group_start_idx = group * 3;
   for (int i = group_start_idx; i < group_start_idx + 3; i++) {
     if (i < s) {
       lcd.setCursor(0, cursor++);
-      lcd.print(TimeMgmt::getScheduleTime(i).toString());
+      lcd.print(TimeMgmt::getScheduleTime(selectedSchedule, i).toString());
       if (i == timeSelectCursorPos) {
-        lcd.print(" <");
+        lcd.print(F(" <"));
       }
     }
     // If schedule is not full, then also print an "add time" option
     if (s < 12 && i == s) {
       lcd.setCursor(0, cursor++);
-      lcd.print("Add time");
+      lcd.print(F("Add time"));
       if (timeSelectCursorPos == i) {
-        lcd.print(" <");
+        lcd.print(F(" <"));
       }
     }
   }
@@ -771,15 +1083,15 @@ static void SystemUI::PrintSetTimesUi() {
   }
   // Print page/group number
   lcd.setCursor(16, 2);
-  lcd.print("Pg ");
+  lcd.print(F("Pg "));
   lcd.print(group + 1);
 }
 static void SystemUI::PrintRemoveTimesUi() {
-  lcd.print("[Remove Times]");
-  uint8_t s = TimeMgmt::getScheduleSize();
+  lcd.print(F("[Remove Times]"));
+  uint8_t s = TimeMgmt::getScheduleSize(selectedSchedule);
   if (s == 0) {
     lcd.setCursor(0, 1);
-    lcd.print("Schedule is empty.");
+    lcd.print(F("Schedule is empty."));
     return; // Early return.
   } // Else, schedule has nonzero # of times, so print/paginate them
   uint8_t group = timeSelectCursorPos / 3;
@@ -788,9 +1100,9 @@ static void SystemUI::PrintRemoveTimesUi() {
   for (int i = group_start_idx; i < group_start_idx + 3; i++) {
     if (i < s) {
       lcd.setCursor(0, cursor);
-      lcd.print(TimeMgmt::getScheduleTime(i).toString());
+      lcd.print(TimeMgmt::getScheduleTime(selectedSchedule, i).toString());
       if (i == timeSelectCursorPos) {
-        lcd.print(" <");
+        lcd.print(F(" <"));
       }
       cursor++;
     }
@@ -810,41 +1122,97 @@ static void SystemUI::PrintRemoveTimesUi() {
   }
   // Print page/group number
   lcd.setCursor(16, 2);
-  lcd.print("Pg ");
+  lcd.print(F("Pg "));
   lcd.print(group + 1);
 }
 static void SystemUI::PrintSetSysTimeUi() {
-  lcd.print("[System Time]");
+  lcd.print(F("[System Time]"));
   lcd.setCursor(0, 1);
-  lcd.print(currentTime->toString());
+  lcd.print(currentTime.toString());
   lcd.setCursor(0, 2);
-  lcd.print("Press OK to change");
+  lcd.print(F("Press OK to change"));
 }
 static void SystemUI::PrintSysInfoUi() {
-  lcd.print("[System Info]");
+  MemoryStats mem;
+  lcd.print(F("[System Info] "));
+  lcd.print(sysInfoPage + 1);
+  lcd.print(F("/"));
+  lcd.print(sysInfoPageCount);
+  if (sysInfoPage == 1) {
+    lcd.setCursor(0, 1);
+    lcd.print(F("Boot: "));
+    lcd.print(bootTime_ms);
+    lcd.print(F(" ms"));
+    lcd.setCursor(0, 2);
+    lcd.print(F("Reset: "));
+    lcd.print(getResetCauseName());
+    lcd.setCursor(0, 3);
+    lcd.print(F("I2C: "));
+    lcd.print(I2CBus::getUtilization());
+    lcd.print(F("% busy, "));
+    lcd.print(I2CBus::getRecoveryCount());
+    lcd.print(F(" rec"));
+    return;
+  }
+  if (sysInfoPage == 2) {
+    mem = MemoryMonitor::getStats();
+    lcd.setCursor(0, 1);
+    lcd.print(F("Stack free: "));
+    lcd.print(mem.stackFree);
+    lcd.setCursor(0, 2);
+    lcd.print(F("Heap top: "));
+    lcd.print(mem.heapBreak);
+    lcd.setCursor(0, 3);
+    lcd.print(F("Free "));
+    lcd.print(mem.freeList);
+    lcd.print(F(" max "));
+    lcd.print(mem.largestFree);
+    return;
+  }
+  if (sysInfoPage == 3) {
+    const JamStats& jams = DoorMgmt::getJamStats();
+    lcd.setCursor(0, 1);
+    lcd.print(F("Jams: "));
+    lcd.print(jams.jams);
+    lcd.print(F(", "));
+    lcd.print(jams.escalated);
+    lcd.print(F(" to OK"));
+    lcd.setCursor(0, 2);
+    lcd.print(F("Retries: "));
+    lcd.print(jams.retries);
+    lcd.print(F(", "));
+    lcd.print(jams.autoCleared);
+    lcd.print(F(" ok"));
+    lcd.setCursor(0, 3);
+    lcd.print(F("Mean recovery: "));
+    lcd.print(jams.recovered ? jams.recoveryTotal_s / jams.recovered : 0);
+    lcd.print(F(" s"));
+    return;
+  }
   lcd.setCursor(0, 1);
-  lcd.print("Version: " + version);
+  lcd.print(F("Version: "));
+  lcd.print(version);
   lcd.setCursor(0, 2);
-  lcd.print("Time: ");
-  lcd.print(currentTime->toString());
+  lcd.print(F("Time: "));
+  lcd.print(currentTime.toString());
   if (debugEnabled) { // Configured during Init()
     lcd.setCursor(0, 3);
-    lcd.print("Debug enabled.");
+    lcd.print(F("Debug enabled."));
   }
 }
 static void SystemUI::PrintResetUi() {
-  lcd.print("  ! RESET SYSTEM !");
+  lcd.print(F("  ! RESET SYSTEM !"));
   lcd.setCursor(0, 1);
-  lcd.print("Are you sure?");
+  lcd.print(F("Are you sure?"));
   lcd.setCursor(0, 2);
-  lcd.print("OK = Confirm");
+  lcd.print(F("OK = Confirm"));
   lcd.setCursor(0, 3);
-  lcd.print("MENU = Cancel");
+  lcd.print(F("MENU = Cancel"));
 }
 static void SystemUI::PrintTimeInputUi() {
   lcd.print(timeInputHeader);
   lcd.setCursor(0, 1);
-  lcd.print(tmp_time->toString());
+  lcd.print(tmp_time.toString());
   // Place the cursor below the digit being selected
   // 11:59:59
   // 01 34 67   <- col idx to set cursor to.
@@ -852,4 +1220,73 @@ static void SystemUI::PrintTimeInputUi() {
   // Print up arrow
   lcd.write(0);
 }
-#pragma endregion LCD_Printing_Methods
+static void SystemUI::PrintRepeatInputUi() {
+  const static char letters[] PROGMEM = "SMTWTFS";
+  uint8_t mask = tmp_rule.getWeekdays();
+  lcd.print(F("[Repeat]"));
+  lcd.setCursor(0, 1);
+  // Weekdays it repeats on, then every N days
+  for (uint8_t d = 0; d < 7; d++) {
+    lcd.print((mask & (1 << d)) ? (char)pgm_read_byte(&letters[d]) : '-');
+  }
+  lcd.print(F("  Every: "));
+  if (tmp_rule.isInterval()) {
+    lcd.print(tmp_rule.getInterval());
+    lcd.print('d');
+  }
+  else {
+    lcd.print(F("--"));
+  }
+  // Place the cursor below the day (or N) being selected
+  lcd.setCursor(repeatCursorPos < 7 ? repeatCursorPos : 16, 2);
+  // Print up arrow
+  lcd.write(0);
+  lcd.setCursor(0, 3);
+  lcd.print(tmp_rule.toString());
+}
+static void SystemUI::PrintSetDateUi() {
+  lcd.print(F("[Set Date]"));
+  lcd.setCursor(0, 1);
+  // 2025-04-25
+  lcd.print(tmp_year);
+  lcd.print(tmp_month < 10 ? F("-0") : F("-"));
+  lcd.print(tmp_month);
+  lcd.print(tmp_day < 10 ? F("-0") : F("-"));
+  lcd.print(tmp_day);
+  // Place the cursor below the field being selected
+  // 2025-04-25
+  //    3  6  9   <- col idx to set cursor to.
+  lcd.setCursor(3 + dateCursorPos * 3, 2);
+  // Print up arrow
+  lcd.write(0);
+}
+static void SystemUI::PrintSettingsUi() {
+  TunableInfo info;
+  Tunables::getInfo((TunableId)settingsCursorPos, &info);
+  lcd.print(F("[Settings] "));
+  lcd.print(settingsCursorPos + 1);
+  lcd.print(F("/"));
+  lcd.print((uint8_t)TunableId::Count);
+  lcd.setCursor(0, 1);
+  lcd.print(info.name);
+  lcd.setCursor(0, 2);
+  // While changing, the new value is marked, with the saved one beside it
+  if (isEditingSetting) {
+    lcd.print(F("> "));
+    lcd.print(tmp_setting);
+    lcd.print(F(" (was "));
+    lcd.print(Tunables::get((TunableId)settingsCursorPos));
+    lcd.print(')');
+  }
+  else {
+    lcd.print(F("= "));
+    lcd.print(Tunables::get((TunableId)settingsCursorPos));
+  }
+  lcd.setCursor(0, 3);
+  lcd.print(info.min);
+  lcd.print('-');
+  lcd.print(info.max);
+  lcd.print(F(", def "));
+  lcd.print(info.def);
+}
+#pragma endregion LCD_Printing_Methods
\ No newline at end of file
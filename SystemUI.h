@@ -3,6 +3,8 @@
 
 #include <Arduino.h> // Arduino code environment
 #include "TimeValue.h"
+#include "EventBus.h"
+#include "Timers.h"
 
 enum class UiButton {
   Up = 0,
@@ -23,18 +25,23 @@ enum class UiState {
   SetTime = 7,
   SystemInfo = 8,
   Reset = 9,
-  TimeInput = 10
+  TimeInput = 10,
+  RepeatInput = 11,
+  SetDate = 12,
+  Settings = 13
 };
 
 class SystemUI {
   public:
+    // Pass as SetText's time_ms for a message that stays until cleared.
+    static const unsigned int noTimeLimit = 0;
     static void Init(bool isDebugEnabled = false, String verNum = "unknown");
     // Disables UI input and sets on-screen text to msg.
     // Use \n for multiple lines.
-    // Accepts optional arg for amount of time, default 5 seconds.
-    static void SetText(String msg, uint8_t timeDelay);
+    // Accepts optional arg for amount of time (ms), default 5 seconds.
+    static void SetText(String msg, unsigned int time_ms);
     // Takes input for the new system time value to display
-    static void UpdateTime(TimeValue* newTime);
+    static void UpdateTime(TimeValue newTime);
     // Input handler for the buttons.
     static void Input(UiButton i);
     // Updates the text displayed on the LCD display.
@@ -49,13 +56,19 @@ class SystemUI {
     static void PauseUi();
     // Setter for unpausing the UI.
     static void UnpauseUi();
-    // Used by the driver to "tick" error delay until it runs out.
-    // Returns true if error delay is done and ready to update ui
-    static bool ErrorTick();
+    // Sends what is left of the last screen update to the LCD (it is sent a little per loop(), so the
+    // time read isn't held up). To be called once per loop().
+    static void FlushTick();
     // Clears error message from the screen, unpauses and updates UI,
     static void ClearError();
+    // Reacts to events from the other modules. Subscribed by Init().
+    static void HandleEvent(Event e);
+    // Records how long boot took (ms from reset until the UI took input), shown in System Info.
+    static void SetBootTime(unsigned long ms);
 
   private:
+    // Ends a message on a time limit. Armed by SetText().
+    static void onTextTimer(uint8_t arg);
     // The logic for how each button input is handled on each UI screen.
     static void HomeUi(UiButton i);
     static void MenuUi(UiButton i);
@@ -68,6 +81,9 @@ class SystemUI {
     static void SysInfoUi(UiButton i);
     static void ResetUi(UiButton i);
     static void TimeInputUi(UiButton i);
+    static void RepeatInputUi(UiButton i);
+    static void SetDateUi(UiButton i);
+    static void SettingsUi(UiButton i);
 
     // The metehods called to print UI text to the screen.
     static void PrintHomeUi();
@@ -81,5 +97,8 @@ class SystemUI {
     static void PrintSysInfoUi();
     static void PrintResetUi();
     static void PrintTimeInputUi();
+    static void PrintRepeatInputUi();
+    static void PrintSetDateUi();
+    static void PrintSettingsUi();
 };
 #endif
\ No newline at end of file
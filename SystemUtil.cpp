@@ -1,9 +1,126 @@
 #include "SystemUtil.h"
+#include <Arduino.h> // Arduino code environment
+#include <avr/wdt.h> // Watchdog timer
 
-void (* setAddrTo0) (void) = 0; // Program counter set to 0 
+// Value of userResetMark when the last reset was requested from the UI.
+const static uint16_t userResetMagic = 0x5EED;
 
+// These are in .noinit RAM, so they are not cleared when the system restarts.
+// (resetFlags is not static, so that the assembly below can refer to it by name.)
+uint8_t resetFlags __attribute__((section(".noinit")));
+static uint16_t userResetMark __attribute__((section(".noinit")));
+static WarmState warmState __attribute__((section(".noinit")));
+static uint16_t warmStateCrc __attribute__((section(".noinit")));
+
+static ResetCause resetCause;
+static bool isWarmStateValid = false;
+
+#ifdef __AVR__
+// Runs before main() and global constructors. Saves the reset flags (Optiboot leaves them in r2
+// after clearing MCUSR) and turns off the watchdog, which stays on after a watchdog reset.
+void captureResetFlags() __attribute__((naked, used, section(".init3")));
+void captureResetFlags() {
+  __asm__ __volatile__("sts resetFlags, r2");
+  resetFlags |= MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+#endif
+
+// Resets the system with the watchdog, which resets every peripheral (unlike jumping to address 0).
 void systemReset(int condition) {
   if (condition == 1) {
-    setAddrTo0();
+    userResetMark = userResetMagic;
+    saveWarmState();
+    wdt_enable(WDTO_15MS);
+    while (true) {} // Wait for the watchdog
+  }
+}
+
+// Works out why the system restarted, checks the warm state, and starts the watchdog.
+// If loop() hangs (e.g. a stuck I2C transaction) for 2 s, the system restarts. So nothing in loop() may
+// wait that long: door moves, pauses and TimeSync's set all run on Timers, and I2C transactions time out.
+void watchdogInit() {
+  if (resetFlags & _BV(WDRF)) {
+    resetCause = userResetMark == userResetMagic ? ResetCause::User : ResetCause::Watchdog;
+  }
+  else if (resetFlags & _BV(BORF)) {
+    resetCause = ResetCause::BrownOut;
+  }
+  else if (resetFlags & _BV(EXTRF)) {
+    resetCause = ResetCause::External;
+  }
+  else {
+    resetCause = ResetCause::PowerOn;
+  }
+  userResetMark = 0;
+  resetFlags = 0;
+  // RAM can't be trusted after power loss, and the CRC catches anything else that corrupted it.
+  isWarmStateValid = resetCause != ResetCause::PowerOn && resetCause != ResetCause::BrownOut
+    && crc16(&warmState, sizeof(warmState)) == warmStateCrc;
+  if (!isWarmStateValid) {
+    warmState.busyDoors = 0;
+    warmState.lastTickTime = -1;
+    saveWarmState();
+  }
+  wdt_enable(WDTO_2S);
+}
+
+// To be called once per loop().
+void watchdogFeed() {
+  wdt_reset();
+}
+
+ResetCause getResetCause() {
+  return resetCause;
+}
+
+// The name is kept in flash, to be printed straight from there.
+const __FlashStringHelper* getResetCauseName() {
+  switch (resetCause) {
+    case ResetCause::External:
+      return F("Reset btn");
+    case ResetCause::BrownOut:
+      return F("Brown-out");
+    case ResetCause::Watchdog:
+      return F("Watchdog");
+    case ResetCause::User:
+      return F("User");
+    case ResetCause::PowerOn:
+      break;
+  }
+  return F("Power on");
+}
+
+// Returns true if the system restarted without losing power, and the warm state was kept.
+bool isWarmRestart() {
+  return isWarmStateValid;
+}
+
+// The state kept across a warm restart. Call saveWarmState() after changing it.
+WarmState* getWarmState() {
+  return &warmState;
+}
+
+void saveWarmState() {
+  warmStateCrc = crc16(&warmState, sizeof(warmState));
+}
+
+// CRC-16/CCITT of length bytes of data.
+uint16_t crc16(const void* data, uint16_t length) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) {
+    crc = crc16Update(crc, bytes[i]);
+  }
+  return crc;
+}
+
+// Adds one byte to a CRC-16/CCITT, for data that isn't all in one place. Start from 0xFFFF.
+uint16_t crc16Update(uint16_t crc, uint8_t data) {
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t b = 0; b < 8; b++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
   }
+  return crc;
 }
\ No newline at end of file
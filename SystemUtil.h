@@ -1,6 +1,32 @@
 #ifndef SYS_UTIL_H
 #define SYS_UTIL_H
 
+#include <Arduino.h> // Arduino code environment
+
+// Why the system last restarted.
+enum class ResetCause : uint8_t {
+  PowerOn = 0,
+  External = 1, // Reset button
+  BrownOut = 2,
+  Watchdog = 3, // The system hung
+  User = 4 // Reset from the UI
+};
+
+// State kept in RAM across a warm restart (anything but power loss). Checked with a CRC at boot.
+struct WarmState {
+  uint8_t busyDoors; // Bit n is set while door n is running its food routine
+  long lastTickTime; // The last time the schedules were checked (# of seconds since 2000-01-01)
+};
+
 void systemReset(int condition);
+void watchdogInit();
+void watchdogFeed();
+ResetCause getResetCause();
+const __FlashStringHelper* getResetCauseName();
+bool isWarmRestart();
+WarmState* getWarmState();
+void saveWarmState();
+uint16_t crc16(const void* data, uint16_t length);
+uint16_t crc16Update(uint16_t crc, uint8_t data);
 
 #endif
\ No newline at end of file
@@ -1,105 +1,648 @@
 #include "TimeMgmt.h"
 #include "TimeValue.h"
 #include "Schedule.h" // 
+#include "ScheduleTimeline.h"
 #include <Arduino.h> // Arduino code environment
-#include <I2C_RTC.h> // For the RTC module
 #include <Wire.h> // For I2C communication
+#include <avr/interrupt.h> // For the square wave's pin change interrupt
 #include "Debug.h"
+#include "Trace.h"
+#include "EventBus.h"
+#include "FeedQueue.h"
+#include "SystemUtil.h"
+#include "I2CBus.h"
+#include <EEPROM.h> // For the schedules kept across a warm restart
+
+// The DS3231's I2C address, and its first time register (seconds, then minutes, hours, day of week, date, month, year)
+const static uint8_t rtcAddress = 0x68, rtcTimeRegister = 0x00;
+// The DS3231's control register (bit 5 starts a temperature conversion), and its aging offset register
+const static uint8_t rtcControlRegister = 0x0E, rtcAgingRegister = 0x10, rtcConvertBit = 0x20;
+// The DS3231's status register, and its bit set when the oscillator stopped (e.g. the battery ran out):
+// the time it keeps can't be trusted until it is set again
+const static uint8_t rtcStatusRegister = 0x0F, rtcStoppedBit = 0x80;
+// The control register's bits that pick the SQW pin's output: INTCN (set = alarm interrupts, clear =
+// square wave) and RS2:RS1 (the rate, 00 = 1 Hz)
+const static uint8_t rtcSquareWaveBits = 0x1C;
+const static uint8_t daysInMonth[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
 // State variables
-static DS3231 RTC;
-Schedule* TimeMgmt::foodSchedule = nullptr;
+static Schedule* schedules[TimeMgmt::maxSchedules];
+static const char* scheduleNames[TimeMgmt::maxSchedules];
+static uint8_t scheduleCount = 0;
+// Upcoming times across all schedules. Rebuilt when a schedule or the system time changes.
+static ScheduleTimeline timeline(TimeMgmt::maxSchedules);
+static bool isTimelineDirty = true;
+// False until Init() has started the RTC (boot brings it up after the UI).
+static bool isClockStarted = false;
+// The date and time (# of seconds since 2000-01-01) as of the last Tick().
+static long lastNow = -1;
+// The last time (# of seconds since 2000-01-01) checked for feedings. Each Tick() checks every time
+// after it up to now, so a late tick still feeds. After a warm restart, it is where the last run left off.
+static long cursor = -1;
+// The # of times the clock was set (by hand or by a sync)
+static uint8_t setCount = 0;
+// The longest gap (seconds) between checks that is caught up on. A bigger gap, or the clock going
+// back by more than this, is a clock jump and is handled by clockJumpPolicy.
+const static long maxCatchUp = 300;
+static ClockJumpPolicy clockJumpPolicy = ClockJumpPolicy::Skip;
+
+// The clock kept by the RTC's 1 Hz square wave: the pin it's on, and the date and time (# of seconds
+// since 2000-01-01, -1 until read from the RTC), which the interrupt counts on at each second.
+static uint8_t squareWavePin = TimeMgmt::noSquareWavePin;
+static volatile long clockNow = -1;
+// Set by each second's edge: when (millis()) it came, whether the time task has seen it yet, and a count
+// of edges (it wraps around) so a read of the RTC can tell if an edge came during it.
+static volatile unsigned long edge_ms;
+static volatile bool hasEdge = false, isSecondPending = false;
+static volatile uint8_t edgeCount = 0;
+// The clock is read back from the RTC this often (s), in case noise added or hid an edge, and after the
+// time is set.
+const static long resyncInterval = 600;
+static long nextResync;
+static bool isResyncDue = true;
+// The most (ms) between edges before the square wave is taken to have stopped, and the time read from the RTC
+const static unsigned long maxEdgeGap_ms = 1500;
+
+// A copy of every schedule, kept in EEPROM (rather than RAM, which it would take ~250 bytes of) so a
+// warm restart can restore them. Layout, from eepromSchedulesBase (past the tunables, with room for more
+// of them): the magic byte, the # of schedules, each one's # of times, then each time and its rule in
+// order, then the CRC-16 of everything before it.
+const static int eepromSchedulesBase = 128;
+const static uint8_t eepromSchedulesMagic = 0x5C;
+
+// Writes n bytes at address a (only those that changed, to spare the EEPROM), and adds them to crc.
+// Returns the address after them.
+static int putBytes(int a, const void* data, uint8_t n, uint16_t* crc) {
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t b = ((const uint8_t*)data)[i];
+    EEPROM.update(a + i, b);
+    *crc = crc16Update(*crc, b);
+  }
+  return a + n;
+}
+
+// Reads n bytes at address a, and adds them to crc. Returns the address after them.
+static int getBytes(int a, void* data, uint8_t n, uint16_t* crc) {
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t b = EEPROM.read(a + i);
+    ((uint8_t*)data)[i] = b;
+    *crc = crc16Update(*crc, b);
+  }
+  return a + n;
+}
+
+// Copies the schedules to EEPROM. To be called after any schedule changes.
+static void saveWarmSchedules() {
+  uint16_t crc = 0xFFFF;
+  int a = putBytes(eepromSchedulesBase, &eepromSchedulesMagic, 1, &crc);
+  a = putBytes(a, &scheduleCount, 1, &crc);
+  for (uint8_t id = 0; id < scheduleCount; id++) {
+    uint8_t size = schedules[id]->getCount();
+    a = putBytes(a, &size, 1, &crc);
+  }
+  for (uint8_t id = 0; id < scheduleCount; id++) {
+    for (uint8_t i = 0; i < schedules[id]->getCount(); i++) {
+      TimeValue time = schedules[id]->getTime(i);
+      Recurrence rule = schedules[id]->getRule(i);
+      a = putBytes(a, &time, sizeof(time), &crc);
+      a = putBytes(a, &rule, sizeof(rule), &crc);
+    }
+  }
+  EEPROM.put(a, crc);
+}
 
-static void TimeMgmt::Init() {
-  RTC.begin();
-  RTC.setYear(2000);
-  RTC.setMonth(1);
-  RTC.setDay(1);
-  RTC.setHours(0);
-  RTC.setMinutes(0);
-  RTC.setSeconds(0);
-  foodSchedule = new Schedule();
+// Reads the # of times in each schedule saved in EEPROM into sizes, and returns true if what was saved
+// is whole (its CRC matches) and is for as many schedules as there are now.
+static bool loadWarmScheduleSizes(uint8_t* sizes) {
+  uint16_t crc = 0xFFFF, saved;
+  uint8_t magic, count, time[sizeof(TimeValue) + sizeof(Recurrence)];
+  int a = getBytes(eepromSchedulesBase, &magic, 1, &crc);
+  a = getBytes(a, &count, 1, &crc);
+  if (magic != eepromSchedulesMagic || count != scheduleCount) {
+    return false;
+  }
+  for (uint8_t id = 0; id < scheduleCount; id++) {
+    a = getBytes(a, &sizes[id], 1, &crc);
+    if (sizes[id] > Schedule::maxTimes) {
+      return false;
+    }
+  }
+  for (uint8_t id = 0; id < scheduleCount; id++) {
+    for (uint8_t i = 0; i < sizes[id]; i++) {
+      a = getBytes(a, time, sizeof(time), &crc);
+    }
+  }
+  EEPROM.get(a, saved);
+  return crc == saved;
+}
+
+// The RTC's square wave: each falling edge is its second ticking over. The rising edges, and the
+// other pins on the port (A0 - A5), are ignored.
+ISR(PCINT1_vect) {
+  if (digitalRead(squareWavePin) != LOW) {
+    return;
+  }
+  if (clockNow >= 0) {
+    clockNow++;
+  }
+  edge_ms = millis();
+  edgeCount++;
+  hasEdge = true;
+  isSecondPending = true;
+}
+
+// Reads the square wave's clock in one go, as the interrupt could change it part way through.
+static long loadClock() {
+  noInterrupts();
+  long now = clockNow;
+  interrupts();
+  return now;
+}
+
+// Sets the square wave's clock from the RTC. A read that an edge came during is thrown away (try again
+// on the next tick), as it can't be told which side of the edge it was.
+static void resync() {
+  long now;
+  uint8_t edges = edgeCount;
+  if (!TimeMgmt::readNow(&now)) {
+    return;
+  }
+  noInterrupts();
+  bool isClean = edgeCount == edges;
+  if (isClean) {
+    clockNow = now;
+  }
+  interrupts();
+  if (isClean) {
+    nextResync = now + resyncInterval;
+    isResyncDue = false;
+  }
+}
+
+// Forgets the square wave's clock once the RTC is set a field at a time, so the time is read from the
+// RTC until the clock is read back from it.
+static void dropClock() {
+  noInterrupts();
+  clockNow = -1;
+  interrupts();
+  isResyncDue = true;
+}
+
+// Writes one of the RTC's registers. Returns false if the bus failed.
+static bool writeRegister(uint8_t reg, uint8_t value) {
+  uint8_t r[2] = {reg, value};
+  return I2CBus::write(rtcAddress, r, sizeof(r), I2CPriority::Rtc);
+}
+
+static void TimeMgmt::Init(uint8_t sqwPin) {
+  uint8_t status;
+  I2CBus::Init();
+  isTimelineDirty = true;
+  isClockStarted = true;
+  // The RTC keeps the date and time while powered off. Only reset them if its oscillator has stopped
+  // since they were set.
+  if (I2CBus::readRegisters(rtcAddress, rtcStatusRegister, &status, 1, I2CPriority::Rtc) && (status & rtcStoppedBit)
+      && setNow(0)) {
+    writeRegister(rtcStatusRegister, status & ~rtcStoppedBit);
+  }
+  // Only A0 - A5 share the interrupt (PCINT1) that counts the square wave
+  if (sqwPin != noSquareWavePin && digitalPinToPCICRbit(sqwPin) == 1) {
+    uint8_t control;
+    if (I2CBus::readRegisters(rtcAddress, rtcControlRegister, &control, 1, I2CPriority::Rtc)) {
+      writeRegister(rtcControlRegister, control & ~rtcSquareWaveBits);
+    }
+    // SQW is open drain
+    pinMode(sqwPin, INPUT_PULLUP);
+    squareWavePin = sqwPin;
+    isResyncDue = true;
+    noInterrupts();
+    *digitalPinToPCMSK(sqwPin) |= _BV(digitalPinToPCMSKbit(sqwPin));
+    PCIFR = _BV(digitalPinToPCICRbit(sqwPin)); // Drop a change seen before now (a flag is cleared by writing 1)
+    PCICR |= _BV(digitalPinToPCICRbit(sqwPin));
+    interrupts();
+  }
+}
+
+// True if the last edge of the square wave was no longer ago than a second (and a bit).
+static bool isEdgeRecent() {
+  if (!hasEdge) {
+    return false;
+  }
+  noInterrupts();
+  unsigned long last_ms = edge_ms;
+  interrupts();
+  return millis() - last_ms < maxEdgeGap_ms;
+}
+
+// True while the RTC's square wave is keeping the clock: its edges are coming, and the clock has been
+// read from the RTC. Otherwise the time is read from the RTC.
+static bool TimeMgmt::isSquareWaveRunning() {
+  return squareWavePin != noSquareWavePin && isEdgeRecent() && loadClock() >= 0;
+}
+
+// Takes the second the last edge started, if it hasn't been taken yet.
+static bool TimeMgmt::takeSecond() {
+  if (!isSecondPending) {
+    return false;
+  }
+  isSecondPending = false;
+  return true;
+}
+
+static bool TimeMgmt::getLastEdge(unsigned long* ms, long* now) {
+  if (!TimeMgmt::isSquareWaveRunning()) {
+    return false;
+  }
+  noInterrupts();
+  *ms = edge_ms;
+  *now = clockNow;
+  interrupts();
+  return *now >= 0;
+}
+
+// The current date and time (# of seconds since 2000-01-01): a load from RAM while the square wave is
+// running, otherwise read from the RTC. Returns false if the bus failed.
+static bool readClock(long* now) {
+  if (TimeMgmt::isSquareWaveRunning()) {
+    *now = loadClock();
+    return true;
+  }
+  // Edges may have been missed, so the clock is read back from the RTC when they start again
+  isResyncDue = true;
+  return TimeMgmt::readNow(now);
+}
+// As readClock(), but the time as of the last Tick() (or 2000-01-01) if the bus failed.
+static long readClockOrLast() {
+  long now;
+  return readClock(&now) ? now : max(lastNow, 0L);
+}
+
+// Splits a day number (# of days since 2000-01-01, up to the end of 2099) into the year (0 - 99),
+// month (0 - 11) and day of the month (0 - 30).
+static void splitDate(uint16_t day, uint8_t* year, uint8_t* month, uint8_t* date) {
+  *year = 0;
+  *month = 0;
+  // Every 4th year from 2000 is a leap year, up to 2099
+  while (day >= (*year % 4 == 0 ? 366 : 365)) {
+    day -= *year % 4 == 0 ? 366 : 365;
+    (*year)++;
+  }
+  while (day >= daysInMonth[*month] - (*month == 1 && *year % 4 != 0)) {
+    day -= daysInMonth[*month] - (*month == 1 && *year % 4 != 0);
+    (*month)++;
+  }
+  *date = day;
 }
 
 static uint8_t TimeMgmt::getSeconds() {
-  return RTC.getSeconds();
+  return readClockOrLast() % 60;
 }
 static uint8_t TimeMgmt::getMinutes() {
-  return RTC.getMinutes();
+  return readClockOrLast() / 60 % 60;
 }
 static uint8_t TimeMgmt::getHours() {
-  return RTC.getHours();
+  return readClockOrLast() % secondsPerDay / 3600;
+}
+// Day of the month (1 - 31)
+static uint8_t TimeMgmt::getDay() {
+  uint8_t year, month, date;
+  splitDate(TimeMgmt::getDayNumber(), &year, &month, &date);
+  return date + 1;
+}
+static uint8_t TimeMgmt::getMonth() {
+  uint8_t year, month, date;
+  splitDate(TimeMgmt::getDayNumber(), &year, &month, &date);
+  return month + 1;
+}
+static uint16_t TimeMgmt::getYear() {
+  uint8_t year, month, date;
+  splitDate(TimeMgmt::getDayNumber(), &year, &month, &date);
+  return 2000 + year;
+}
+// Returns today's day number (# of days since 2000-01-01).
+static uint16_t TimeMgmt::getDayNumber() {
+  return readClockOrLast() / secondsPerDay;
+}
+static uint8_t fromBcd(uint8_t bcd) {
+  return (bcd >> 4) * 10 + (bcd & 0x0F);
+}
+static uint8_t toBcd(uint8_t value) {
+  return (value / 10) << 4 | (value % 10);
+}
+
+// Returns the current date and time as # of seconds since 2000-01-01.
+// While the RTC's square wave is running this is a load from RAM. Otherwise the date and time are read
+// in one burst, rather than a transaction per field, which also means they can't be torn (e.g. the time
+// read just after midnight with the date from just before).
+// If the bus fails, the time as of the last Tick() is returned.
+static long TimeMgmt::getNow() {
+  long now;
+  if (!readClock(&now)) {
+    return lastNow;
+  }
+  TRACE_TIME(now);
+  return now;
 }
 
-static TimeValue* TimeMgmt::getSysTime() {
-  TimeValue* t = new TimeValue();
-  t->seconds = getSeconds();
-  t->minutes = getMinutes();
-  t->hours = getHours();
-  return t;
+// Reads the current date and time (# of seconds since 2000-01-01) like getNow(), but without tracing
+// it, for callers that read it every pass of loop(). Returns false if the bus failed.
+static bool TimeMgmt::readNow(long* now) {
+  uint8_t r[7];
+  if (!isClockStarted || !I2CBus::readRegisters(rtcAddress, rtcTimeRegister, r, sizeof(r), I2CPriority::Rtc)) {
+    return false;
+  }
+  uint8_t h;
+  if (r[2] & 0x40) { // 12 hour mode: bit 5 is PM
+    h = fromBcd(r[2] & 0x1F) % 12 + (r[2] & 0x20 ? 12 : 0);
+  }
+  else {
+    h = fromBcd(r[2] & 0x3F);
+  }
+  long day = Recurrence::dayNumber(2000 + fromBcd(r[6]), fromBcd(r[5] & 0x1F), fromBcd(r[4] & 0x3F));
+  *now = day * secondsPerDay + TimeValue(h, fromBcd(r[1] & 0x7F), fromBcd(r[0] & 0x7F)).totalSeconds();
+  return true;
+}
+
+// Sets the date and time (# of seconds since 2000-01-01, up to the end of 2099) in one burst write, so
+// the fields can't be torn by a second ticking over between them. The DS3231 restarts its second when
+// the seconds register is written, so the new second starts on the write. Returns false if the bus failed.
+static bool TimeMgmt::setNow(long now) {
+  uint8_t r[8];
+  uint8_t year, month, date;
+  if (!isClockStarted || now < 0 || now >= 36525L * secondsPerDay) {
+    return false;
+  }
+  TimeValue time = TimeValue::fromSeconds(now);
+  r[0] = rtcTimeRegister;
+  r[1] = toBcd(time.getSeconds());
+  r[2] = toBcd(time.getMinutes());
+  r[3] = toBcd(time.getHours()); // 24 hour mode
+  r[4] = Recurrence::weekday(now / secondsPerDay) + 1; // 1 = Sunday
+  splitDate(now / secondsPerDay, &year, &month, &date);
+  r[5] = toBcd(date + 1);
+  r[6] = toBcd(month + 1);
+  r[7] = toBcd(year);
+  if (!I2CBus::write(rtcAddress, r, sizeof(r), I2CPriority::Rtc)) {
+    return false;
+  }
+  // The RTC's second starts over on the write, so the square wave's clock starts from it too
+  noInterrupts();
+  clockNow = now;
+  edge_ms = millis();
+  interrupts();
+  nextResync = now + resyncInterval;
+  isTimelineDirty = true;
+  setCount++;
+  return true;
 }
 
+// The # of times the clock has been set (it wraps around), so a caller can tell whether the RTC has run
+// undisturbed since it last looked.
+static uint8_t TimeMgmt::getSetCount() {
+  return setCount;
+}
+
+// The DS3231's aging offset: each step up slows its oscillator by ~0.1 ppm (at 25 C), and down speeds it up.
+// Returns false if the bus failed.
+static bool TimeMgmt::getAgingOffset(int8_t* offset) {
+  return isClockStarted && I2CBus::readRegisters(rtcAddress, rtcAgingRegister, (uint8_t*)offset, 1, I2CPriority::Rtc);
+}
+// Sets the aging offset, then starts a temperature conversion, which is when the DS3231 applies it
+// (otherwise it would wait up to 64 s for the next one). Returns false if the bus failed.
+static bool TimeMgmt::setAgingOffset(int8_t offset) {
+  uint8_t control;
+  if (!isClockStarted || !writeRegister(rtcAgingRegister, (uint8_t)offset)
+    || !I2CBus::readRegisters(rtcAddress, rtcControlRegister, &control, 1, I2CPriority::Rtc)) {
+    return false;
+  }
+  return writeRegister(rtcControlRegister, control | rtcConvertBit);
+}
+
+static TimeValue TimeMgmt::getSysTime() {
+  return TimeValue::fromSeconds(readClockOrLast());
+}
+
+// Each of these writes one of the RTC's time registers. They return false if the value is not valid or
+// the bus failed.
 static bool TimeMgmt::setSeconds(uint8_t s) {
-  if (s < 60) {
-    RTC.setSeconds(s);
+  if (s < 60 && writeRegister(rtcTimeRegister, toBcd(s))) {
+    isTimelineDirty = true;
+    dropClock();
+    setCount++;
     return true;
   }
   return false;
 }
 static bool TimeMgmt::setMinutes(uint8_t m) {
-  if (m < 60) {
-    RTC.setMinutes(m);
+  if (m < 60 && writeRegister(rtcTimeRegister + 1, toBcd(m))) {
+    isTimelineDirty = true;
+    dropClock();
+    setCount++;
     return true;
   }
   return false;
 }
 static bool TimeMgmt::setHours(uint8_t h) {
-  if (h < 24) {
-    RTC.setHours(h);
+  if (h < 24 && writeRegister(rtcTimeRegister + 2, toBcd(h))) { // 24 hour mode
+    isTimelineDirty = true;
+    dropClock();
+    setCount++;
     return true;
   }
   return false;
 }
-static uint8_t TimeMgmt::getScheduleSize() {
-  return TimeMgmt::foodSchedule->getCount();
+// Sets the date (year 2000 - 2099), and the day of the week from it, in one write. Returns false if the
+// date is not valid or the bus failed.
+static bool TimeMgmt::setDate(uint16_t year, uint8_t month, uint8_t day) {
+  if (year < 2000 || year > 2099 || month < 1 || month > 12 || day < 1 || day > daysInMonth[month - 1]) {
+    return false;
+  }
+  // Feb 29 only in leap years: every 4th year from 2000, up to 2099 (as the UI allows)
+  if (month == 2 && day == 29 && year % 4 != 0) {
+    return false;
+  }
+  // Day of week (1 = Sunday), date, month and year follow the time registers
+  uint8_t r[5] = {(uint8_t)(rtcTimeRegister + 3), (uint8_t)(Recurrence::weekday(Recurrence::dayNumber(year, month, day)) + 1),
+    toBcd(day), toBcd(month), toBcd(year - 2000)};
+  if (!I2CBus::write(rtcAddress, r, sizeof(r), I2CPriority::Rtc)) {
+    return false;
+  }
+  isTimelineDirty = true;
+  dropClock();
+  setCount++;
+  return true;
 }
-static TimeValue TimeMgmt::getScheduleTime(uint8_t index) {
-  return TimeMgmt::foodSchedule->getTime(index);
+
+// Adds a new, empty schedule. Returns its id, or 255 if there is no room for another schedule.
+static uint8_t TimeMgmt::addSchedule(const char* name) {
+  if (scheduleCount >= maxSchedules) {
+    return 255;
+  }
+  schedules[scheduleCount] = new Schedule();
+  scheduleNames[scheduleCount] = name;
+  isTimelineDirty = true;
+  return scheduleCount++;
+}
+
+// After a warm restart, restores the schedules as they were, and catches up any feedings due while
+// restarting. To be called once the schedules are added. Returns true if the schedules were restored.
+static bool TimeMgmt::restoreWarmState() {
+  ScheduleEdit edits[Schedule::maxTimes];
+  uint8_t results[Schedule::maxTimes];
+  uint8_t sizes[maxSchedules];
+  uint16_t crc = 0xFFFF;
+  if (!isWarmRestart() || !loadWarmScheduleSizes(sizes)) {
+    saveWarmSchedules();
+    return false;
+  }
+  // The times follow the magic byte, the # of schedules and their sizes
+  int a = eepromSchedulesBase + 2 + scheduleCount;
+  for (uint8_t id = 0; id < scheduleCount; id++) {
+    for (uint8_t i = 0; i < sizes[id]; i++) {
+      edits[i].op = ScheduleEditOp::Add;
+      a = getBytes(a, &edits[i].time, sizeof(TimeValue), &crc);
+      a = getBytes(a, &edits[i].rule, sizeof(Recurrence), &crc);
+    }
+    // Not checked against MinTimeDiff again: the times were apart enough when they were set, and a
+    // MinTimeDiff raised since then shouldn't throw the schedule away
+    schedules[id]->applyBatch(edits, sizes[id], results, false);
+  }
+  cursor = getWarmState()->lastTickTime;
+  isTimelineDirty = true;
+  DEBUG_PRINTLN(Time, F("Restored schedules after warm restart."));
+  return true;
+}
+static uint8_t TimeMgmt::getScheduleCount() {
+  return scheduleCount;
+}
+static const char* TimeMgmt::getScheduleName(uint8_t sched) {
+  return scheduleNames[sched];
+}
+static uint8_t TimeMgmt::getScheduleSize(uint8_t sched) {
+  return schedules[sched]->getCount();
+}
+static TimeValue TimeMgmt::getScheduleTime(uint8_t sched, uint8_t index) {
+  return schedules[sched]->getTime(index);
+}
+
+static Recurrence TimeMgmt::getScheduleRule(uint8_t sched, uint8_t index) {
+  return schedules[sched]->getRule(index);
 }
 
 // Returns: 1 = success, 2 = failed (time conlflict), 0 = failed (bad index)
-static uint8_t TimeMgmt::setScheduleTime(uint8_t index, uint8_t h, uint8_t m, uint8_t s) {
-  if (index == TimeMgmt::foodSchedule->getCount()) {
+static uint8_t TimeMgmt::setScheduleTime(uint8_t sched, uint8_t index, uint8_t h, uint8_t m, uint8_t s, Recurrence rule) {
+  uint8_t response;
+  isTimelineDirty = true;
+  if (index == schedules[sched]->getCount()) {
     // Add time
-    return TimeMgmt::foodSchedule->addTime(h, m, s);
+    response = schedules[sched]->addTime(h, m, s, rule);
   }
   else {
     // Update time
-    return TimeMgmt::foodSchedule->updateTime(index, h, m, s);
+    response = schedules[sched]->updateTime(index, h, m, s, rule);
   }
+  saveWarmSchedules();
+  return response;
+}
+static bool TimeMgmt::removeScheduleTime(uint8_t sched, uint8_t index) {
+  isTimelineDirty = true;
+  bool isRemoved = schedules[sched]->removeTime(index);
+  saveWarmSchedules();
+  return isRemoved;
 }
-static bool TimeMgmt::removeScheduleTime(uint8_t index) {
-  return TimeMgmt::foodSchedule->removeTime(index);
+// Applies several adds/updates/removes to the schedule at once, or none of them if any fail.
+// Per-edit codes are written to results: 1 = success, 2 = failed (time conflict), 0 = failed (bad index)
+static bool TimeMgmt::applyScheduleBatch(uint8_t sched, const ScheduleEdit* edits, uint8_t editCount, uint8_t* results) {
+  isTimelineDirty = true;
+  bool isApplied = schedules[sched]->applyBatch(edits, editCount, results);
+  saveWarmSchedules();
+  return isApplied;
 }
 
-// Returns true if the current time is a feeding time in the schedule.
-static bool TimeMgmt::isFeedingTime() {
-  uint8_t s = TimeMgmt::foodSchedule->getCount();
-  if (s == 0) return false;
-  TimeValue* ct = TimeMgmt::getSysTime();
-  long time_seconds = ct->totalSeconds(), tmp_seconds;
-  delete ct;
-  for (int i = 0; i < s; i++) {
-    tmp_seconds = TimeMgmt::getScheduleTime(i).totalSeconds();
-    if (time_seconds == tmp_seconds) {
-      // This is feeding time
-      return true;
-    }
-    if (time_seconds < tmp_seconds) {
-      // since the schedule is smallest time first, and our search is linear, if our current time
-      // is before the feeding time we are looking at, it is not feeding time.
-      return false;
+// Rebuilds the timeline from the cursor (or the current time, if the clock has jumped away from it)
+// if a schedule or the system time has changed.
+static void TimeMgmt::ensureTimeline() {
+  if (!isTimelineDirty) return;
+  long now = TimeMgmt::getNow();
+  bool isNearCursor = cursor >= 0 && now - cursor <= maxCatchUp && cursor - now <= maxCatchUp;
+  timeline.rebuild(schedules, scheduleCount, isNearCursor ? cursor + 1 : now);
+  isTimelineDirty = false;
+}
+
+// Queues a feeding for the schedule's door and posts FeedDue.
+static void TimeMgmt::postFeedDue(uint8_t sched, long when) {
+  FeedQueue::push(sched, when);
+  EventBus::post(EventType::FeedDue, sched);
+}
+
+// Reads the current time. Posts TimeChanged when it has changed, and FeedDue for each time that came
+// due since the last check (the half-open window cursor < time <= now), so each time is fed exactly
+// once however late the tick is.
+static void TimeMgmt::Tick() {
+  TimelineEvent e;
+  // While the square wave runs, read its clock back from the RTC now and then, or when it isn't known
+  if (isEdgeRecent() && (isResyncDue || lastNow >= nextResync)) {
+    resync();
+  }
+  long now = TimeMgmt::getNow();
+  if (now == lastNow) {
+    return; // Still the same second
+  }
+  lastNow = now;
+  EventBus::post(EventType::TimeChanged);
+  if (cursor < 0) {
+    cursor = now - 1; // First check since a cold start: only times due right now
+  }
+  long gap = now - cursor;
+  if (gap <= 0 && gap >= -maxCatchUp) {
+    return; // The clock went back a little: the times up to the cursor were already fed.
+  }
+  if (gap < 0 || gap > maxCatchUp) {
+    // The clock jumped (it was set, or the system was off for a while). On a jump forward, feed each
+    // schedule once that had a time skipped over, if configured to.
+    uint8_t index;
+    for (uint8_t id = 0; gap > 0 && clockJumpPolicy == ClockJumpPolicy::FeedOnce && id < scheduleCount; id++) {
+      long when = schedules[id]->nextOccurrence(cursor + 1, &index);
+      if (when >= 0 && when < now) {
+        postFeedDue(id, when);
+      }
     }
+    DEBUG_PRINTLN(Time, "Clock jumped by " + String(gap) + " s");
+    cursor = now - 1;
+    isTimelineDirty = true;
   }
-  return false;
+  TimeMgmt::ensureTimeline();
+  // Only the head of the timeline needs to be looked at, until it is in the future.
+  while (timeline.peek(&e) && e.key <= now) {
+    postFeedDue(e.scheduleId, e.key);
+    timeline.advance();
+  }
+  cursor = now;
+  FeedQueue::expire(now);
+  getWarmState()->lastTickTime = now;
+  saveWarmState();
+}
+
+static void TimeMgmt::setClockJumpPolicy(ClockJumpPolicy policy) {
+  clockJumpPolicy = policy;
+}
+
+// Returns the time of day as of the last Tick().
+static TimeValue TimeMgmt::getLastTime() {
+  return TimeValue::fromSeconds(lastNow);
+}
+
+// Finds the next feeding across all schedules. Returns false if every schedule is empty.
+static bool TimeMgmt::getNextFeeding(uint8_t* sched, TimeValue* time) {
+  TimelineEvent e;
+  if (!isClockStarted) {
+    return false; // Not known until the RTC is up
+  }
+  TimeMgmt::ensureTimeline();
+  if (!timeline.peek(&e)) {
+    return false;
+  }
+  *sched = e.scheduleId;
+  *time = schedules[e.scheduleId]->getTime(e.index);
+  return true;
 }
\ No newline at end of file
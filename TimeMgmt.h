@@ -5,24 +5,69 @@
 #include "TimeValue.h"
 #include "Schedule.h"
 
+// What Tick() does with the feedings skipped over when the clock jumps forward (by more than a few
+// minutes, e.g. when the clock is set). Small gaps, like a late tick, are always caught up on.
+enum class ClockJumpPolicy : uint8_t {
+  Skip,     // Start over from the new time
+  FeedOnce, // Feed each schedule once that had a time skipped over
+};
+
 class TimeMgmt {
   private:
-    
+    static void ensureTimeline();
+    static void postFeedDue(uint8_t sched, long when);
   public:
-    static Schedule* foodSchedule;
-    static void Init();
+    // The max number of schedules (e.g. one per pet, hopper or portion size).
+    static const uint8_t maxSchedules = 3;
+    // For Init(): no square wave from the RTC is wired up
+    static const uint8_t noSquareWavePin = 255;
+    // Starts the RTC. If the DS3231's SQW output is wired to squareWavePin (one of A0 - A5, which share
+    // a pin change interrupt), it's set to a 1 Hz square wave which keeps a clock in RAM: each falling
+    // edge counts it on a second, in step with the RTC's own. Time reads are then a load from RAM, and
+    // the RTC is only read now and then to check the clock, and after the time is set. Without it (or
+    // if the wave stops), the time is read from the RTC each time.
+    static void Init(uint8_t squareWavePin = noSquareWavePin);
+    // True while the square wave is keeping the clock.
+    static bool isSquareWaveRunning();
+    // True once for each of the RTC's seconds, on the first call after it starts, to run a task in step
+    // with it. Only meaningful while isSquareWaveRunning().
+    static bool takeSecond();
+    // The square wave's last edge: when it came (millis()), and the second it started. Returns false
+    // unless isSquareWaveRunning().
+    static bool getLastEdge(unsigned long* ms, long* now);
     static uint8_t getSeconds();
     static uint8_t getMinutes();
     static uint8_t getHours();
-    static TimeValue* getSysTime();
+    static uint8_t getDay();
+    static uint8_t getMonth();
+    static uint16_t getYear();
+    static uint16_t getDayNumber();
+    static long getNow();
+    static bool readNow(long* now);
+    static bool setNow(long now);
+    static uint8_t getSetCount();
+    static bool getAgingOffset(int8_t* offset);
+    static bool setAgingOffset(int8_t offset);
+    static TimeValue getSysTime();
     static bool setSeconds(uint8_t s);
     static bool setMinutes(uint8_t m);
     static bool setHours(uint8_t h);
-    static uint8_t getScheduleSize();
-    static TimeValue getScheduleTime(uint8_t index);
-    static uint8_t setScheduleTime(uint8_t index, uint8_t h, uint8_t m, uint8_t s);
-    static bool removeScheduleTime(uint8_t index);
-    static bool isFeedingTime();
+    static bool setDate(uint16_t year, uint8_t month, uint8_t day);
+    static uint8_t addSchedule(const char* name);
+    static bool restoreWarmState();
+    static uint8_t getScheduleCount();
+    static const char* getScheduleName(uint8_t sched);
+    static uint8_t getScheduleSize(uint8_t sched);
+    static TimeValue getScheduleTime(uint8_t sched, uint8_t index);
+    static Recurrence getScheduleRule(uint8_t sched, uint8_t index);
+    static uint8_t setScheduleTime(uint8_t sched, uint8_t index, uint8_t h, uint8_t m, uint8_t s, Recurrence rule = Recurrence::daily());
+    static bool removeScheduleTime(uint8_t sched, uint8_t index);
+    static bool applyScheduleBatch(uint8_t sched, const ScheduleEdit* edits, uint8_t editCount, uint8_t* results);
+    // To be called at least once per second (on takeSecond(), while the square wave is running).
+    static void Tick();
+    static void setClockJumpPolicy(ClockJumpPolicy policy);
+    static TimeValue getLastTime();
+    static bool getNextFeeding(uint8_t* sched, TimeValue* time);
 };
 
 #endif
\ No newline at end of file
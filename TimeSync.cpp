@@ -0,0 +1,160 @@
+#include <Arduino.h> // Arduino code environment
+#include "TimeSync.h"
+#include "TimeMgmt.h"
+#include "SerialCommands.h"
+#include "Timers.h"
+#include "Debug.h"
+
+// How far ahead (ms) a set must be: far enough to see the RTC's second tick over first, and near enough
+// that millis() running fast or slow (the Uno's resonator is only good to ~0.5%) barely matters.
+const static unsigned long minLead_ms = 1100, maxLead_ms = 10000;
+// How long (ms) before the set the RTC is read for its second ticking over, when there's no square wave
+// to show it: a little over a second, so it's bound to tick over within it.
+const static unsigned long watchLead_ms = 1100;
+// How long (s) the RTC must run undisturbed before its drift is trimmed. A few ms of error in the
+// measurement is only ~0.1 ppm (one aging step) over this long.
+const static long minDriftInterval = 12L * 3600;
+// The most drift (ppm) the aging offset can trim (-128 - 127 steps of ~0.1 ppm). More than this means
+// something other than drift moved the clock, so it isn't trimmed.
+const static float maxDrift_ppm = 12.7;
+// The most (s) the RTC can be off and still have its error measured (more doesn't fit in a long of ms).
+const static long maxError = 3600;
+
+// The set waiting for its time: its timer, the millis() to set it at, and the time to set it to
+static TimerId setTimer = Timers::none;
+static unsigned long setAt_ms;
+static long setTo;
+// When the RTC's second last ticked over while waiting (millis()), and the time it ticked over to. Also
+// whether the RTC is being read for it, and the last read.
+static bool hasEdge, isWatching;
+static unsigned long edge_ms;
+static long edgeTime, lastRead;
+// The last sync since boot (-1 if none), the RTC's error (ms) found then, and TimeMgmt's set count after it
+static long lastSync = -1;
+static long lastError_ms;
+static bool hasLastError = false;
+static uint8_t lastSetCount;
+
+static void runCommand(const char* line);
+
+static void TimeSync::Init() {
+  setTimer = Timers::none;
+  if (TIMESYNC_ENABLED) {
+    Serial.begin(9600);
+    SerialCommands::subscribe('s', runCommand);
+  }
+}
+
+// Trims the RTC's drift from the error (ms) it built up over elapsed (s) since the last sync.
+static void trimDrift(long error_ms, long elapsed) {
+  int8_t aging;
+  float drift_ppm = error_ms * 1000.0 / elapsed;
+  if (fabs(drift_ppm) > maxDrift_ppm || !TimeMgmt::getAgingOffset(&aging)) {
+    return;
+  }
+  // A fast RTC (a positive error) is slowed by a higher aging offset
+  long trimmed = max(-128L, min(127L, aging + lround(drift_ppm * 10)));
+  if (trimmed != aging) {
+    TimeMgmt::setAgingOffset((int8_t)trimmed);
+    DEBUG_PRINTLN(Time, "RTC drift " + String(drift_ppm) + " ppm, aging offset " + String(trimmed));
+  }
+}
+
+// Sets the RTC as asked, then measures the drift since the last sync (if it can) and trims it. Runs from
+// the set's timer, so within a pass of loop() of setAt_ms.
+static void runSet(uint8_t) {
+  setTimer = Timers::none;
+  isWatching = false;
+  int8_t aging = 0;
+  long error_ms = 0;
+  // The square wave's last edge is the RTC's second ticking over, without reading the RTC for it
+  if (!hasEdge) {
+    hasEdge = TimeMgmt::getLastEdge(&edge_ms, &edgeTime);
+  }
+  bool hasError = hasEdge && edgeTime - setTo <= maxError && setTo - edgeTime <= maxError;
+  if (!TimeMgmt::setNow(setTo)) {
+    Serial.println(F("ERR"));
+    return;
+  }
+  if (hasError) {
+    // The RTC had just started edgeTime at edge_ms, when the reference was (edge_ms - setAt_ms) ms
+    // (negative) from starting setTo
+    error_ms = (edgeTime - setTo) * 1000 - (long)(edge_ms - setAt_ms);
+    if (lastSync >= 0 && lastSetCount == (uint8_t)(TimeMgmt::getSetCount() - 1)
+      && setTo - lastSync >= minDriftInterval) {
+      trimDrift(error_ms, setTo - lastSync);
+    }
+  }
+  lastSync = setTo;
+  lastError_ms = error_ms;
+  hasLastError = hasError;
+  lastSetCount = TimeMgmt::getSetCount();
+  TimeMgmt::getAgingOffset(&aging);
+  Serial.print(F("SYNC "));
+  Serial.print(setTo);
+  Serial.print(' ');
+  if (hasError) Serial.print(error_ms);
+  else Serial.print('?');
+  Serial.print(' ');
+  Serial.println((int)aging);
+}
+
+// Runs a command line (see TimeSync.h), as soon as it arrives.
+static void runCommand(const char* line) {
+  unsigned long now = millis();
+  char* rest;
+  int8_t aging = 0;
+  unsigned long a, b;
+  if (line[1] == '\0') {
+    TimeMgmt::getAgingOffset(&aging);
+    Serial.print(F("A "));
+    Serial.print((int)aging);
+    Serial.print(' ');
+    Serial.print(lastSync);
+    Serial.print(' ');
+    if (hasLastError) Serial.println(lastError_ms);
+    else Serial.println('?');
+    return;
+  }
+  a = strtoul(line + 1, &rest, 10);
+  if (*rest == '\0') {
+    // A timestamp exchange. t3 is taken last, just before the reply goes into Serial's buffer.
+    Serial.print(F("S "));
+    Serial.print(a);
+    Serial.print(' ');
+    Serial.print(now);
+    Serial.print(' ');
+    Serial.println(millis());
+    return;
+  }
+  b = strtoul(rest, &rest, 10);
+  if (*rest != '\0' || a - now < minLead_ms || a - now > maxLead_ms || (long)b < 0 || !TimeMgmt::readNow(&lastRead)) {
+    Serial.println(F("ERR"));
+    return;
+  }
+  setAt_ms = a;
+  setTo = b;
+  hasEdge = false;
+  isWatching = false;
+  Timers::cancel(&setTimer);
+  setTimer = Timers::start(a - now, runSet);
+  Serial.println(Timers::isArmed(setTimer) ? F("OK") : F("ERR"));
+}
+
+static void TimeSync::Poll() {
+  long read;
+  if (!TIMESYNC_ENABLED) return;
+  // Only in the last watchLead_ms before a set, until it's found, and only without the square wave
+  if (!Timers::isArmed(setTimer) || hasEdge || (long)(millis() - (setAt_ms - watchLead_ms)) < 0
+    || TimeMgmt::isSquareWaveRunning() || !TimeMgmt::readNow(&read)) {
+    return;
+  }
+  // The first read only starts the watch, as the time read with the command is seconds old by now
+  if (isWatching && read != lastRead) {
+    edge_ms = millis();
+    edgeTime = read;
+    hasEdge = true;
+  }
+  lastRead = read;
+  isWatching = true;
+}
\ No newline at end of file
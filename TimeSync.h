@@ -0,0 +1,44 @@
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Compile-time switch for syncing the clock over Serial (1 = on, 0 = off). Off by default, as Serial's
+// buffers take ~160 bytes of RAM. Can also be set with -D, e.g. -DTIMESYNC_ENABLED=1.
+#ifndef TIMESYNC_ENABLED
+#define TIMESYNC_ENABLED 0
+#endif
+
+// Sets the RTC from a reference clock on a PC (tools/timesync/timesync.py), to within a few ms rather
+// than to the nearest second by hand, and trims the RTC's drift over repeated syncs.
+//
+// The PC first finds how far millis() is from its own clock, NTP style: it sends its time T1, this
+// notes millis() as the line arrives (t2) and as it replies (t3), and the PC notes when the reply
+// arrives (T4). The offset is ((t2 - T1) + (t3 - T4)) / 2 and the round trip (T4 - T1) - (t3 - t2);
+// the exchanges with the shortest round trips give the best offsets. The PC then names a millis() at
+// which a second starts, and which second it is. The RTC is set right then in one write, which also
+// restarts the DS3231's second, so its seconds tick over with the reference's.
+//
+// The set runs from a timer, so nothing waits on it. How far the RTC had drifted is measured from when
+// its second last ticked over before the set: the square wave's last edge, or without it, the RTC is
+// read each pass of loop() in the last second or so before the set until its second ticks over. If the
+// RTC ran undisturbed for at least minDriftInterval since the last sync (since boot), the drift is
+// trimmed with the DS3231's aging offset.
+//
+// Serial commands (one per line, times in ms):
+//   s <T1>         replies "S <T1> <t2> <t3>"
+//   s <M> <S>      sets the RTC to S (# of seconds since 2000-01-01) when millis() reaches M, which must
+//                  be 1.1 - 10 s away so the RTC's second can be found first. Replies "OK", and once set
+//                  "SYNC <S> <error> <aging>": how far (ms) the RTC was ahead of the reference (or "?" if
+//                  it couldn't be measured), and the aging offset now. Replies "ERR" if it can't be set.
+//   s              replies "A <aging> <last sync> <last error>" (last sync: S, or -1 if none since boot)
+class TimeSync {
+  public:
+    // Takes the 's' commands from SerialCommands (if compiled in); a set then runs from a timer.
+    static void Init();
+    // Watches for the RTC's second ticking over just before a set, when there's no square wave to show
+    // it. To be called every pass of loop().
+    static void Poll();
+};
+
+#endif
\ No newline at end of file
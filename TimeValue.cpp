@@ -1,19 +1,15 @@
 #include "TimeValue.h"
 #include <Arduino.h> // Arduino code environment
 
-bool TimeValue::isValid() {
-  return seconds < 60 && minutes < 60 && hours < 24;
-}
+// Compile-time checks of the time math
+static_assert(TimeValue(23, 59, 30).distance(TimeValue(0, 0, 1)) == 31, "distance wraps past midnight");
+static_assert(TimeValue(0, 0, 1).until(TimeValue(23, 59, 30)) == 86369, "until goes forward");
+static_assert(TimeValue(23, 59, 59).plus(2) == TimeValue(0, 0, 1), "plus wraps past midnight");
+static_assert(TimeValue::fromSeconds(-1).getHours() == 23, "fromSeconds wraps negative times");
 
-String TimeValue::toString() {
+String TimeValue::toString() const {
+  uint8_t hours = getHours(), minutes = getMinutes(), seconds = getSeconds();
   return (hours < 10 ? "0" : "") + String(hours) + ":"
     + (minutes < 10 ? "0" : "") + String(minutes) + ":"
     + (seconds < 10 ? "0" : "") + String(seconds);
-}
-
-long TimeValue::totalSeconds() {
-  long h = hours;
-  long m = minutes;
-  long s = seconds;
-  return h * 3600 + m * 60 + s;
 }
\ No newline at end of file
@@ -3,14 +3,55 @@
 
 #include <Arduino.h> // Arduino code environment
 
+// The # of seconds in a day
+const static long secondsPerDay = 86400;
+
+// A time of day, packed into the # of seconds since midnight, so comparing and subtracting times
+// is plain integer math. Everything but toString() and the setters can be done at compile time.
 class TimeValue {
   public:
-    uint8_t seconds;
-    uint8_t minutes;
-    uint8_t hours;
-    bool isValid();
-    String toString();
-    long totalSeconds();
+    // Midnight
+    constexpr TimeValue() : value(0) {}
+    constexpr TimeValue(uint8_t h, uint8_t m, uint8_t s) : value(h * 3600L + m * 60 + s) {}
+    // The time s seconds after midnight. s is wrapped into the day, so it may be negative or a whole date.
+    static constexpr TimeValue fromSeconds(long s) {
+      return TimeValue((s % secondsPerDay + secondsPerDay) % secondsPerDay, true);
+    }
+    // Whether h, m and s are each in range. To be checked before packing them: the constructor and the
+    // setters carry e.g. 75 minutes into the hour, which isValid() on the packed time can't catch.
+    static constexpr bool isValid(uint8_t h, uint8_t m, uint8_t s) {
+      return h < 24 && m < 60 && s < 60;
+    }
+    constexpr bool isValid() const { return value < (uint32_t)secondsPerDay; }
+    constexpr uint8_t getHours() const { return value / 3600; }
+    constexpr uint8_t getMinutes() const { return value / 60 % 60; }
+    constexpr uint8_t getSeconds() const { return value % 60; }
+    constexpr long totalSeconds() const { return value; }
+    // The # of seconds from this time forward to t, past midnight if need be (0 - 86399).
+    constexpr long until(TimeValue t) const {
+      return t.value >= value ? t.value - value : t.value + secondsPerDay - value;
+    }
+    // The # of seconds between this time and t, the shorter way around the clock (0 - 43200).
+    constexpr long distance(TimeValue t) const {
+      return until(t) < t.until(*this) ? until(t) : t.until(*this);
+    }
+    // This time plus s seconds (may be negative), wrapped into the day.
+    constexpr TimeValue plus(long s) const { return fromSeconds(value + s); }
+    constexpr bool operator==(TimeValue t) const { return value == t.value; }
+    constexpr bool operator!=(TimeValue t) const { return value != t.value; }
+    constexpr bool operator<(TimeValue t) const { return value < t.value; }
+    constexpr bool operator>(TimeValue t) const { return value > t.value; }
+    constexpr bool operator<=(TimeValue t) const { return value <= t.value; }
+    constexpr bool operator>=(TimeValue t) const { return value >= t.value; }
+    // Change one field. Hours may go past 23 (e.g. while a digit is being entered), which isValid() catches;
+    // minutes and seconds must be 0 - 59.
+    void setHours(uint8_t h) { value = TimeValue(h, getMinutes(), getSeconds()).value; }
+    void setMinutes(uint8_t m) { value = TimeValue(getHours(), m, getSeconds()).value; }
+    void setSeconds(uint8_t s) { value = TimeValue(getHours(), getMinutes(), s).value; }
+    String toString() const;
+  private:
+    uint32_t value;
+    constexpr TimeValue(long s, bool) : value(s) {}
 };
 
 #endif
\ No newline at end of file
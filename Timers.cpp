@@ -0,0 +1,119 @@
+#include <Arduino.h> // Arduino code environment
+#include "Timers.h"
+#include "Trace.h"
+
+// # of wheel slots (1 ms each). Must be a power of 2. A pass of loop() longer than this looks at every slot once.
+const static uint8_t wheelSize = 16;
+// The end of a list
+const static uint8_t noTimer = 0xFF;
+// The lists after the wheel's slots: the timers not in use
+const static uint8_t freeList = wheelSize;
+
+struct Timer {
+  unsigned long due_ms;
+  TimerCallback callback;
+  uint8_t arg;
+  // # of times this slot has been armed (the high byte of its TimerId)
+  uint8_t uses;
+  // The list it's in (a wheel slot, or freeList), and its neighbours there
+  uint8_t list, prev, next;
+};
+
+static Timer timers[Timers::maxTimers];
+static uint8_t heads[wheelSize + 1];
+// The last ms whose slot has been looked at
+static unsigned long lastPoll_ms;
+
+// Adds timer t to the front of a list.
+static void link(uint8_t t, uint8_t list) {
+  timers[t].list = list;
+  timers[t].prev = noTimer;
+  timers[t].next = heads[list];
+  if (heads[list] != noTimer) {
+    timers[heads[list]].prev = t;
+  }
+  heads[list] = t;
+}
+
+// Takes timer t out of its list.
+static void unlink(uint8_t t) {
+  if (timers[t].prev != noTimer) {
+    timers[timers[t].prev].next = timers[t].next;
+  }
+  else {
+    heads[timers[t].list] = timers[t].next;
+  }
+  if (timers[t].next != noTimer) {
+    timers[timers[t].next].prev = timers[t].prev;
+  }
+}
+
+static void Timers::Init() {
+  for (uint8_t i = 0; i <= wheelSize; i++) {
+    heads[i] = noTimer;
+  }
+  for (uint8_t t = 0; t < maxTimers; t++) {
+    timers[t].uses = 0;
+    link(t, freeList);
+  }
+  lastPoll_ms = millis();
+}
+
+static TimerId Timers::start(unsigned long delay_ms, TimerCallback callback, uint8_t arg) {
+  uint8_t t = heads[freeList];
+  if (t == noTimer) {
+    return none;
+  }
+  unlink(t);
+  timers[t].due_ms = millis() + delay_ms;
+  // A slot that has already been looked at would only come around again a turn of the wheel later
+  if ((long)(timers[t].due_ms - lastPoll_ms) <= 0) {
+    timers[t].due_ms = lastPoll_ms + 1;
+  }
+  timers[t].callback = callback;
+  timers[t].arg = arg;
+  timers[t].uses++;
+  link(t, timers[t].due_ms & (wheelSize - 1));
+  return (TimerId)timers[t].uses << 8 | t;
+}
+
+static bool Timers::isArmed(TimerId id) {
+  uint8_t t = id & 0xFF;
+  return t < maxTimers && timers[t].list != freeList && timers[t].uses == id >> 8;
+}
+
+static void Timers::cancel(TimerId* id) {
+  if (Timers::isArmed(*id)) {
+    unlink(*id & 0xFF);
+    link(*id & 0xFF, freeList);
+  }
+  *id = none;
+}
+
+static void Timers::Poll() {
+  unsigned long now = millis();
+  unsigned long elapsed = now - lastPoll_ms;
+  unsigned long from = lastPoll_ms + 1;
+  bool isTraced = false;
+  // Timers armed by the callbacks are due from the next ms on, so they wait for the next pass
+  lastPoll_ms = now;
+  for (uint8_t i = 0; i < min(elapsed, (unsigned long)wheelSize); i++) {
+    uint8_t slot = (from + i) & (wheelSize - 1);
+    uint8_t t = heads[slot];
+    while (t != noTimer) {
+      if ((long)(now - timers[t].due_ms) < 0) {
+        t = timers[t].next; // Due on a later turn of the wheel
+        continue;
+      }
+      unlink(t);
+      link(t, freeList);
+      if (!isTraced) {
+        TRACE(Task, (uint8_t)TraceTask::Timer, 0);
+        isTraced = true;
+      }
+      timers[t].callback(timers[t].arg);
+      // The callback may have armed or cancelled timers in this slot, so start it over
+      t = heads[slot];
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include <Arduino.h> // Arduino code environment
+
+typedef void (*TimerCallback)(uint8_t arg);
+// Identifies an armed timer, to cancel it. The low byte is its slot and the high byte how many times
+// that slot has been used, so the id of a timer that has already gone off won't cancel a newer one in
+// its slot, until the count wraps (256 uses of the slot later). So an id is to be set to none, or
+// replaced, once its timer has gone off, not kept around.
+typedef uint16_t TimerId;
+
+// One-shot software timers, with ms resolution, for every timeout and pause: modules arm a timer
+// rather than counting down in a task or waiting in delay(). Callbacks are run from loop() (by Poll()),
+// never from an interrupt, so they can do anything other main code can.
+//
+// A hashed timer wheel driven from millis(): each timer is kept in the wheel slot of the ms it's due
+// (mod the wheel size), so arming and cancelling are O(1), and each ms that passes only its own slot is
+// looked at. A timer due further out than one turn of the wheel stays put until its ms comes around.
+class Timers {
+  public:
+    // The most timers armed at once (one per door, the UI's message, the reset and a time sync).
+    static const uint8_t maxTimers = 8;
+    static const TimerId none = 0xFFFF;
+    static void Init();
+    // Arms a timer: callback(arg) runs once, delay_ms from now (at the soonest on the next ms).
+    // Returns its id, or none if every timer is in use.
+    static TimerId start(unsigned long delay_ms, TimerCallback callback, uint8_t arg = 0);
+    // Disarms the timer (if it hasn't gone off yet), and sets *id to none.
+    static void cancel(TimerId* id);
+    // True until the timer goes off or is cancelled.
+    static bool isArmed(TimerId id);
+    // Runs the callbacks of the timers that are due. To be called every pass of loop().
+    static void Poll();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "Trace.h"
+#include <Arduino.h> // Arduino code environment
+#include "TimeMgmt.h"
+#include "Tunables.h"
+#include "SerialCommands.h"
+
+static TraceRecord records[TRACE_ENABLED ? TRACE_SIZE : 1];
+// Where the next record goes, and the # of records kept
+static uint8_t head = 0, count = 0;
+// The day of the last RtcRead, so RtcDay is only recorded when it changes
+static long lastDay = -1;
+
+// The 't' command: dumps the trace.
+static void runCommand(const char*) {
+  Trace::dump();
+}
+
+static void Trace::Init() {
+  if (!TRACE_ENABLED) return;
+  Serial.begin(9600);
+  SerialCommands::subscribe('t', runCommand);
+  head = 0;
+  count = 0;
+  lastDay = -1;
+}
+
+static void Trace::record(TraceType type, uint8_t arg, uint16_t value) {
+  TraceRecord* r = &records[head];
+  r->time = millis();
+  r->type = type;
+  r->arg = arg;
+  r->value = value;
+  head = (head + 1) % TRACE_SIZE;
+  if (count < TRACE_SIZE) {
+    count++;
+  }
+}
+
+static void Trace::recordTime(long now) {
+  long day = now / 86400;
+  long secondOfDay = now % 86400;
+  if (day != lastDay) {
+    lastDay = day;
+    Trace::record(TraceType::RtcDay, 0, day);
+  }
+  Trace::record(TraceType::RtcRead, secondOfDay % 60, secondOfDay / 60);
+}
+
+// Format, one item per line:
+// TRACE <# of records> <# of schedules>
+// S <schedule> <hours> <minutes> <seconds> <repeat days> <repeat anchor>
+// P <tunable id> <value>
+// R <time> <type> <arg> <value>
+// END
+static void Trace::dump() {
+  Recurrence rule;
+  TimeValue t;
+  Serial.print(F("TRACE "));
+  Serial.print(count);
+  Serial.print(' ');
+  Serial.println(TimeMgmt::getScheduleCount());
+  // The schedules aren't traced, so send them with the trace for the replay to start from
+  for (uint8_t i = 0; i < TimeMgmt::getScheduleCount(); i++) {
+    for (uint8_t j = 0; j < TimeMgmt::getScheduleSize(i); j++) {
+      t = TimeMgmt::getScheduleTime(i, j);
+      rule = TimeMgmt::getScheduleRule(i, j);
+      Serial.print(F("S "));
+      Serial.print(i);
+      Serial.print(' ');
+      Serial.print(t.getHours());
+      Serial.print(' ');
+      Serial.print(t.getMinutes());
+      Serial.print(' ');
+      Serial.print(t.getSeconds());
+      Serial.print(' ');
+      Serial.print(rule.days);
+      Serial.print(' ');
+      Serial.println(rule.anchorDay);
+    }
+  }
+  // Same for the tunables, as the timing and thresholds depend on them
+  for (uint8_t i = 0; i < (uint8_t)TunableId::Count; i++) {
+    Serial.print(F("P "));
+    Serial.print(i);
+    Serial.print(' ');
+    Serial.println((unsigned)Tunables::get((TunableId)i));
+  }
+  // Oldest first
+  for (uint8_t i = 0; i < count; i++) {
+    TraceRecord* r = &records[(head + TRACE_SIZE - count + i) % TRACE_SIZE];
+    Serial.print(F("R "));
+    Serial.print(r->time);
+    Serial.print(' ');
+    Serial.print((uint8_t)r->type);
+    Serial.print(' ');
+    Serial.print(r->arg);
+    Serial.print(' ');
+    Serial.println(r->value);
+  }
+  Serial.println(F("END"));
+}
\ No newline at end of file
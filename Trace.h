@@ -0,0 +1,57 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Compile-time switch for the trace recorder (1 = on, 0 = off). When off, trace points compile to
+// nothing and the buffer takes no RAM. Can also be set with -D, e.g. -DTRACE_ENABLED=1.
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+// # of records kept (6 bytes each). The oldest are overwritten first.
+#ifndef TRACE_SIZE
+#define TRACE_SIZE 48
+#endif
+
+// What a trace record holds. The replayer (tools/replay) depends on these values.
+enum class TraceType : uint8_t {
+  Task = 0, // A task ran. arg = TraceTask
+  Button = 1, // A button was pressed. arg = UiButton
+  RtcRead = 2, // The time was read. arg = seconds, value = minutes into the day
+  RtcDay = 3, // The day changed since the last RtcRead. value = # of days since 2000-01-01
+  Adc = 4, // A sensor was read. arg = door index (+ 0x80 for motor current), value = reading
+  Motor = 5 // A motor was started or stopped. arg = door index (+ 0x80 if opening), value = duty
+};
+
+// Tasks in loop() that are traced.
+enum class TraceTask : uint8_t {
+  Time = 0,
+  Door = 1,
+  Timer = 2 // Timers::Poll() ran the callbacks of timers that were due
+};
+
+struct TraceRecord {
+  uint16_t time; // millis(), low 16 bits
+  TraceType type;
+  uint8_t arg;
+  uint16_t value;
+};
+
+// Records inputs and timing into a ring buffer, to be dumped over Serial and replayed on a PC.
+class Trace {
+  public:
+    // Also takes the 't' command from SerialCommands, to dump the trace.
+    static void Init();
+    static void record(TraceType type, uint8_t arg, uint16_t value);
+    // Records a time read from the RTC (# of seconds since 2000-01-01).
+    static void recordTime(long now);
+    // Prints the schedules and then the records, oldest first, as text.
+    static void dump();
+};
+
+// Trace points. Only compiled in when TRACE_ENABLED is 1, e.g.
+// TRACE(Adc, doorIndex, read);
+#define TRACE(type, arg, value) do { if (TRACE_ENABLED) Trace::record(TraceType::type, arg, value); } while (0)
+#define TRACE_TIME(now) do { if (TRACE_ENABLED) Trace::recordTime(now); } while (0)
+
+#endif
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include <Arduino.h> // Arduino code environment
+#include <EEPROM.h>
+#include "Tunables.h"
+#include "SystemUtil.h" // For crc16Update
+#include "SerialCommands.h"
+#include "Debug.h"
+
+// By TunableId. Kept in flash (PROGMEM), as RAM is short.
+const static TunableInfo table[(uint8_t)TunableId::Count] PROGMEM = {
+  {"Motor duty", 50, 255, 250, 5},
+  {"Door time ms", 500, 10000, 2500, 100},
+  {"Jam light high", 0, 1023, 40, 1},
+  {"Jam light low", 0, 1023, 20, 1},
+  {"Stall current", 100, 1023, 500, 10},
+  {"Jam retries", 0, 10, 4, 1},
+  {"Retry delay s", 5, 3600, 30, 5},
+  {"Time gap s", 1, 3600, 60, 10},
+  {"Time task ms", 250, 5000, 1000, 50},
+  {"UI task ms", 5, 100, 10, 1},
+  {"Door task ms", 20, 500, 100, 10},
+  {"Light sep. (sd)", 1, 10, 3, 1},
+  {"Light window", 4, 200, 32, 4},
+};
+
+// EEPROM layout, from eepromBase: the magic byte, the # of tunables saved, the values (2 bytes each,
+// by id), then the CRC-16 of everything before it. Tunables added since the values were saved start
+// at their defaults; values saved by a build with more tunables than this one aren't used.
+// This may take up to 128 bytes: TimeMgmt keeps the schedules from there on.
+const static int eepromBase = 0;
+const static uint8_t eepromMagic = 0xA7;
+
+uint16_t Tunables::values[(uint8_t)TunableId::Count];
+
+static void runCommand(const char* line);
+
+static void Tunables::getInfo(TunableId id, TunableInfo* info) {
+  memcpy_P(info, &table[(uint8_t)id], sizeof(TunableInfo));
+}
+
+static void Tunables::Init() {
+  TunableInfo info;
+  uint8_t count = EEPROM.read(eepromBase + 1);
+  uint16_t crc = 0xFFFF, saved;
+  bool isValid = EEPROM.read(eepromBase) == eepromMagic && count > 0 && count <= (uint8_t)TunableId::Count;
+  for (int a = eepromBase; isValid && a < eepromBase + 2 + count * 2; a++) {
+    crc = crc16Update(crc, EEPROM.read(a));
+  }
+  EEPROM.get(eepromBase + 2 + count * 2, saved);
+  isValid = isValid && crc == saved;
+  DEBUG_PRINTLN(Main, isValid ? F("Tunables loaded.") : F("No tunables saved, using defaults."));
+  for (uint8_t i = 0; i < (uint8_t)TunableId::Count; i++) {
+    getInfo((TunableId)i, &info);
+    values[i] = info.def;
+    if (isValid && i < count) {
+      EEPROM.get(eepromBase + 2 + i * 2, saved);
+      // A value outside the range (e.g. the range has since been narrowed) falls back to the default
+      if (saved >= info.min && saved <= info.max) {
+        values[i] = saved;
+      }
+    }
+  }
+  if (TUNABLES_SERIAL_ENABLED) {
+    Serial.begin(9600);
+    SerialCommands::subscribe('p', runCommand);
+  }
+}
+
+static bool Tunables::set(TunableId id, uint16_t value) {
+  TunableInfo info;
+  if ((uint8_t)id >= (uint8_t)TunableId::Count) {
+    return false;
+  }
+  getInfo(id, &info);
+  if (value < info.min || value > info.max) {
+    return false;
+  }
+  if (values[(uint8_t)id] != value) {
+    values[(uint8_t)id] = value;
+    save();
+  }
+  return true;
+}
+
+static void Tunables::resetAll() {
+  TunableInfo info;
+  for (uint8_t i = 0; i < (uint8_t)TunableId::Count; i++) {
+    getInfo((TunableId)i, &info);
+    values[i] = info.def;
+  }
+  save();
+}
+
+// Writes every value, and the header and CRC. EEPROM.update() only writes the bytes that changed,
+// which saves wear, as each cell lasts ~100,000 writes.
+static void Tunables::save() {
+  uint16_t crc = 0xFFFF;
+  EEPROM.update(eepromBase, eepromMagic);
+  EEPROM.update(eepromBase + 1, (uint8_t)TunableId::Count);
+  for (uint8_t i = 0; i < (uint8_t)TunableId::Count; i++) {
+    EEPROM.put(eepromBase + 2 + i * 2, values[i]);
+  }
+  for (int a = eepromBase; a < eepromBase + 2 + (uint8_t)TunableId::Count * 2; a++) {
+    crc = crc16Update(crc, EEPROM.read(a));
+  }
+  EEPROM.put(eepromBase + 2 + (uint8_t)TunableId::Count * 2, crc);
+}
+
+static void printTunable(uint8_t i) {
+  TunableInfo info;
+  Tunables::getInfo((TunableId)i, &info);
+  Serial.print(F("P "));
+  Serial.print(i);
+  Serial.print(' ');
+  Serial.print((unsigned)Tunables::get((TunableId)i));
+  Serial.print(' ');
+  Serial.print((unsigned)info.min);
+  Serial.print(' ');
+  Serial.print((unsigned)info.max);
+  Serial.print(' ');
+  Serial.print((unsigned)info.def);
+  Serial.print(' ');
+  Serial.println(info.name);
+}
+
+// Runs a command line (see Tunables.h).
+static void runCommand(const char* line) {
+  char* rest;
+  long id, value;
+  if (line[1] == '\0') {
+    for (uint8_t i = 0; i < (uint8_t)TunableId::Count; i++) {
+      printTunable(i);
+    }
+    return;
+  }
+  if (strcmp_P(line, PSTR("p d")) == 0) {
+    Tunables::resetAll();
+    Serial.println(F("OK"));
+    return;
+  }
+  id = strtol(line + 1, &rest, 10);
+  value = strtol(rest, &rest, 10);
+  if (id < 0 || id >= (long)TunableId::Count || value < 0 || value > 0xFFFF
+    || !Tunables::set((TunableId)id, (uint16_t)value)) {
+    Serial.println(F("ERR"));
+    return;
+  }
+  printTunable(id);
+}
\ No newline at end of file
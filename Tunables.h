@@ -0,0 +1,63 @@
+#ifndef TUNABLES_H
+#define TUNABLES_H
+
+#include <Arduino.h> // Arduino code environment
+
+// Compile-time switch for changing tunables over Serial (1 = on, 0 = off). Off by default, as Serial's
+// buffers take ~160 bytes of RAM; the tunables can still be changed from System Menu > Settings.
+// Can also be set with -D, e.g. -DTUNABLES_SERIAL_ENABLED=1.
+#ifndef TUNABLES_SERIAL_ENABLED
+#define TUNABLES_SERIAL_ENABLED 0
+#endif
+
+// The constants that can be changed without a rebuild. Each is saved in EEPROM at its id, so ids
+// must never be reused or reordered: only add new ones before Count.
+enum class TunableId : uint8_t {
+  WorkDuty = 0, // The motor's duty while the door moves
+  DoorTime = 1, // How long (ms) a move takes
+  JamHigh = 2, // Photoresistor reading above which a closed door is jammed (until its readings are learned)
+  JamLow = 3, // Photoresistor reading below which an open door is jammed (until its readings are learned)
+  StallCurrent = 4, // Motor current (ADC counts) above which the motor is stalled
+  JamRetries = 5, // Automatic retries after a jam before waiting on OK (0 = only on OK)
+  JamRetryDelay = 6, // Wait (s) before the first automatic retry; doubles after each failed one
+  MinTimeDiff = 7, // How far apart (s) the times of a schedule must be
+  IntervalTime = 8, // Time task interval (ms), while the RTC's square wave isn't running
+  IntervalUi = 9, // UI task interval (ms)
+  IntervalDoorCheck = 10, // Door task interval (ms)
+  LightSeparation = 11, // How many standard deviations apart a door's open and closed light readings must stay
+  LightWindow = 12, // # of light readings the learned jam thresholds follow
+  Count
+};
+
+// What is known about a tunable: its name (shown on the LCD, so at most 16 characters), its range,
+// its compile-time default, and how far one Up/Down press moves it.
+struct TunableInfo {
+  char name[17];
+  uint16_t min, max, def, step;
+};
+
+// Behaviour-critical constants, with compile-time defaults and ranges, saved in EEPROM so each unit
+// can be tuned in the field (from System Menu > Settings, or over Serial).
+// Values are kept in RAM, so reading one on the hot path is a plain load.
+//
+// Serial commands (one per line):
+//   p             lists every tunable: "P <id> <value> <min> <max> <default> <name>"
+//   p <id> <v>    sets a tunable and saves it, then lists it (or prints "ERR" if out of range)
+//   p d           sets every tunable back to its default, and saves them
+class Tunables {
+  public:
+    // Loads the saved values, or the defaults if none are saved (or they are damaged), and takes the
+    // 'p' commands from SerialCommands (if compiled in).
+    static void Init();
+    static uint16_t get(TunableId id) { return values[(uint8_t)id]; }
+    // Sets and saves a tunable. Returns false (leaving it as it was) if value is out of its range.
+    static bool set(TunableId id, uint16_t value);
+    // Sets every tunable back to its default, and saves them.
+    static void resetAll();
+    static void getInfo(TunableId id, TunableInfo* info);
+  private:
+    static uint16_t values[(uint8_t)TunableId::Count];
+    static void save();
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""Reads the waveform captures the firmware sends over Serial (see Capture.h) and exports or plots them.
+
+Usage:
+  capture.py [--csv DIR] [--plot] FILE        captures saved from the Serial port to FILE
+  capture.py [--csv DIR] [--plot] --port /dev/ttyACM0 [--baud 9600] [--count N]
+                                              captures read live (needs pyserial)
+
+Each capture is summarized on stdout. --csv writes one CSV per capture (time_ms, photoresistor,
+motor, opening), and --plot draws them (needs matplotlib).
+"""
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"CAP\x01"
+HEADER = struct.Struct("<4sBBHBHH")  # magic, door, flags, interval (us), duty, # of samples, first sample
+
+
+def crc16(data):
+    """CRC-16/CCITT, as crc16() in SystemUtil.cpp."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+class Capture:
+    def __init__(self, door, flags, interval_us, duty, first, samples):
+        self.door = door
+        self.is_jam = bool(flags & 1)
+        self.interval_us = interval_us
+        self.duty = duty
+        self.first = first
+        self.samples = samples
+
+    def rows(self):
+        """(time since the motor started in ms, photoresistor, motor running, opening) per sample."""
+        for i, s in enumerate(self.samples):
+            t = (self.first + i) * self.interval_us / 1000.0
+            yield t, s & 0x3FF, (s >> 15) & 1, (s >> 14) & 1
+
+    def summary(self):
+        rows = list(self.rows())
+        readings = [r[1] for r in rows]
+        running = [r for r in rows if r[2]]
+        text = "door %d, %d samples at %g Hz from %.1f ms%s" % (
+            self.door + 1, len(rows), 1e6 / self.interval_us, rows[0][0] if rows else 0,
+            ", ended in a jam" if self.is_jam else "")
+        if readings:
+            text += "\n  photoresistor min %d, max %d, last %d" % (min(readings), max(readings), readings[-1])
+        if running:
+            text += "\n  motor ran %.1f ms (%s, duty %d)" % (
+                running[-1][0] - running[0][0] + self.interval_us / 1000.0,
+                "opening" if running[-1][3] else "closing", self.duty)
+        return text
+
+
+def parse(data):
+    """Finds every capture in data (other Serial output may be mixed in). Returns (captures, # of bad blocks)."""
+    captures, bad = [], 0
+    pos = data.find(MAGIC)
+    while pos >= 0:
+        if pos + HEADER.size > len(data):
+            break
+        _, door, flags, interval, duty, count, first = HEADER.unpack_from(data, pos)
+        end = pos + HEADER.size + count * 2
+        if end + 2 > len(data):
+            break
+        (crc,) = struct.unpack_from("<H", data, end)
+        if crc != crc16(data[pos:end]):
+            bad += 1
+            pos = data.find(MAGIC, pos + 1)
+            continue
+        samples = struct.unpack_from("<%dH" % count, data, pos + HEADER.size)
+        captures.append(Capture(door, flags, interval, duty, first, samples))
+        pos = data.find(MAGIC, end + 2)
+    return captures, bad
+
+
+def read_port(port, baud, count):
+    import serial  # pyserial
+    data = b""
+    with serial.Serial(port, baud, timeout=1) as s:
+        while len(parse(data)[0]) < count:
+            data += s.read(256)
+    return data
+
+
+def write_csv(captures, directory):
+    os.makedirs(directory, exist_ok=True)
+    for n, c in enumerate(captures):
+        path = os.path.join(directory, "capture%d_door%d.csv" % (n + 1, c.door + 1))
+        with open(path, "w") as f:
+            f.write("time_ms,photoresistor,motor,opening\n")
+            for row in c.rows():
+                f.write("%.3f,%d,%d,%d\n" % row)
+        print("wrote", path)
+
+
+def plot(captures):
+    import matplotlib.pyplot as plt
+    fig, axes = plt.subplots(len(captures), 1, squeeze=False, sharex=False)
+    for ax, c in zip(axes[:, 0], captures):
+        rows = list(c.rows())
+        t = [r[0] for r in rows]
+        ax.plot(t, [r[1] for r in rows], label="photoresistor")
+        ax.fill_between(t, 0, [r[2] * 1023 for r in rows], step="post", alpha=0.15, label="motor running")
+        ax.set_ylim(0, max([r[1] for r in rows] + [60]) * 1.2)
+        ax.set_title("Door %d%s" % (c.door + 1, " (jam)" if c.is_jam else ""))
+        ax.set_xlabel("ms since motor start")
+        ax.legend(loc="upper right")
+    plt.tight_layout()
+    plt.show()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("file", nargs="?")
+    ap.add_argument("--port")
+    ap.add_argument("--baud", type=int, default=9600)
+    ap.add_argument("--count", type=int, default=1, help="# of captures to wait for on --port")
+    ap.add_argument("--csv", metavar="DIR")
+    ap.add_argument("--plot", action="store_true")
+    args = ap.parse_args()
+    if args.port:
+        data = read_port(args.port, args.baud, args.count)
+    elif args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        ap.error("give a FILE or --port")
+
+    captures, bad = parse(data)
+    for n, c in enumerate(captures):
+        print("Capture %d: %s" % (n + 1, c.summary()))
+    if bad:
+        print("%d capture(s) failed the CRC check" % bad, file=sys.stderr)
+    if not captures:
+        print("no captures found", file=sys.stderr)
+        return 1
+    if args.csv:
+        write_csv(captures, args.csv)
+    if args.plot:
+        plot(captures)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,63 @@
+// What the fleet simulator (fleet.cpp) and each simulated device (device.cpp) pass each other.
+// Plain data only: the device side is a separately loaded copy of the firmware.
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdint.h>
+
+const static int fleetMaxTimes = 12;
+// Histogram buckets: bucket 0 holds 0, bucket n holds 2^(n-1) up to 2^n - 1, and the last bucket the rest.
+const static int fleetBuckets = 16;
+
+struct DeviceConfig {
+  uint32_t seed;
+  int days;
+  // The feeding schedule (daily times)
+  int timeCount;
+  uint8_t hours[fleetMaxTimes], minutes[fleetMaxTimes];
+  // RTC error (parts per million), photoresistor noise (standard deviation, ADC counts),
+  // chance of each door move jamming, mean time (s) for someone to clear a jam, and button presses per day
+  double driftPpm, noise, jamRate, meanRecovery_s, buttonsPerDay;
+  // How much of the difference between the open and closed light readings is lost by the end of the
+  // run (0 - 1), as the sensor gathers dust and the light ages
+  double lightLoss;
+  // FeedStalePolicy, and the max age (s) of a queued feeding
+  uint8_t stalePolicy;
+  long maxAge_s;
+  // The jam retry Tunables (JamRetries, JamRetryDelay)
+  uint8_t maxRetries;
+  uint16_t retryDelay_s;
+};
+
+struct DeviceStats {
+  // Feedings: scheduled, dispensed, and scheduled ones never dispensed (within 2 h, or merged into another)
+  uint32_t expected, dispensed, missed;
+  // Jams: injected by the simulation, detected by the firmware (including false ones, from noise),
+  // and cleared. Recovery is from detection until the door is running again.
+  uint32_t jamsInjected, jamsDetected, jamsCleared;
+  // Jams detected with nothing in the way, and light drift warnings
+  uint32_t falseJams, lightDriftWarnings;
+  // Automatic retries made, jams they cleared, and jams left to the operator (from DoorMgmt::getJamStats())
+  uint32_t retries, autoCleared, escalated;
+  uint64_t recoveryTotal_s;
+  uint32_t recoveryMax_s;
+  // Passes of loop(), by how long each spent on the hardware (us, simulated: see SimHardware::busy_us),
+  // and feedings by how late they started (s)
+  uint64_t loopPasses;
+  uint64_t loopHistogram[fleetBuckets];
+  uint32_t latencyHistogram[fleetBuckets];
+  uint32_t recoveryHistogram[fleetBuckets];
+};
+
+typedef void (*FleetRunDevice)(const DeviceConfig* config, DeviceStats* stats);
+
+static inline int fleetBucket(uint64_t v) {
+  int b = 0;
+  while (v > 0 && b < fleetBuckets - 1) {
+    v >>= 1;
+    b++;
+  }
+  return b;
+}
+
+#endif
@@ -0,0 +1,261 @@
+// One simulated feeder for the fleet simulator: the whole sketch, run against the simulated hardware
+// with a door, a person and a clock that misbehave in random (but seeded) ways.
+// This is built into a shared library with the firmware, and fleet.cpp loads a fresh copy of it for
+// each device, so every device starts from the firmware's initial state.
+// <random> has to come before Arduino.h, whose min/max macros break it
+#include <math.h>
+#include <random>
+#include <Arduino.h>
+#include "Fleet.h"
+#include "HostHardware.h"
+#include "SWE6823_Project.ino"
+// The Arduino min/max macros get in the way of std::min/max
+#undef min
+#undef max
+
+// Photoresistor readings with the door closed and fully open, and motor current (ADC counts)
+// running freely and stalled
+const static double darkReading = 10, brightReading = 60, runCurrent = 150, stallCurrent = 600;
+// How long (ms) the door takes to go from closed to fully open
+const static double travel_ms = 2000;
+// The chance that backing a jammed door off (reversing it) frees it
+const static double freedByReverse = 0.4;
+// A scheduled feeding not started within this long (s) is missed
+const static long missedAfter_s = 7200;
+// The longest the simulation skips ahead (ms) while nothing is happening
+const static unsigned long maxSkip_ms = 60000;
+
+namespace {
+
+struct Device {
+  const DeviceConfig* config;
+  DeviceStats* stats;
+  std::mt19937 rng;
+  long rtcStart;
+  // The door: how far open (0 - 1), whether the motor is running (and since when), and whether it is stuck
+  double position = 0;
+  bool isMotorOn = false, isOpening = false, isStuck = false, isStall = false;
+  unsigned long motorSince = 0;
+  // Feedings due (RTC time) that haven't started yet, and the next one to come due
+  std::deque<long> pending;
+  long nextDue;
+  // The person: when the next button is pressed, when it is let go, and when a jam is next seen to
+  unsigned long nextButton, buttonRelease = 0, nextJamVisit = 0;
+  uint8_t heldButton = 0;
+  // What the firmware was doing on the last pass
+  bool wasJammed = false, wasDispensing = false;
+  unsigned long jamStart = 0;
+
+  double uniform() { return std::uniform_real_distribution<double>(0, 1)(rng); }
+  double exponential(double mean) { return -mean * log(1 - uniform()); }
+  double noise() { return std::normal_distribution<double>(0, config->noise)(rng); }
+
+  // The RTC runs fast or slow by driftPpm
+  long rtcAt(unsigned long ms) {
+    return rtcStart + (long)floor(ms * (1 + config->driftPpm * 1e-6) / 1000);
+  }
+  unsigned long msAt(long rtc) {
+    return (unsigned long)ceil((rtc - rtcStart) * 1000.0 / (1 + config->driftPpm * 1e-6));
+  }
+
+  // The first scheduled time at or after t (RTC time)
+  long dueAfter(long t) {
+    long best = -1;
+    for (int i = 0; i < config->timeCount; i++) {
+      long secondOfDay = config->hours[i] * 3600L + config->minutes[i] * 60L;
+      long when = t / 86400 * 86400 + secondOfDay;
+      if (when < t) when += 86400;
+      if (best < 0 || when < best) best = when;
+    }
+    return best;
+  }
+
+  // Moves the door for the time the motor has run since it was last looked at.
+  void moveDoor() {
+    if (isMotorOn && !isStuck) {
+      double d = (sim->millis - motorSince) / travel_ms;
+      position = std::min(1.0, std::max(0.0, position + (isOpening ? d : -d)));
+    }
+    motorSince = sim->millis;
+  }
+
+  void onMotor(int duty) {
+    moveDoor();
+    bool isStarting = duty > 0 && !isMotorOn;
+    bool isReversing = isStarting && isOpening != (sim->pinLevel[Direction[0]] == HIGH);
+    isMotorOn = duty > 0;
+    isOpening = sim->pinLevel[Direction[0]] == HIGH;
+    if (isReversing && isStuck && uniform() < freedByReverse) {
+      isStuck = false;
+    }
+    if (isStarting && !isStuck && uniform() < config->jamRate) {
+      // Something blocks the door. Half the time the motor stalls against it; otherwise it slips.
+      isStuck = true;
+      isStall = uniform() < 0.5;
+      stats->jamsInjected++;
+    }
+  }
+
+  void updateInputs() {
+    sim->rtcNow = rtcAt(sim->millis);
+    moveDoor();
+    double loss = config->lightLoss * sim->millis / (config->days * 86400000.0);
+    double light = darkReading + (brightReading - darkReading) * (1 - loss) * position + noise();
+    sim->analogIn[Photoresistor[0]] = std::max(0, std::min(1023, (int)lround(light)));
+    // The motor stalls against something in the way, or against the stop at the end of travel
+    bool isAtStop = isOpening ? position >= 1 : position <= 0;
+    double current = isMotorOn ? ((isStuck && isStall) || isAtStop ? stallCurrent : runCurrent) + noise() : 0;
+    sim->analogIn[CurrentSense[0]] = std::max(0, std::min(1023, (int)lround(current)));
+    // Buttons
+    if (heldButton && sim->millis >= buttonRelease) {
+      sim->pinLevel[heldButton] = LOW;
+      heldButton = 0;
+    }
+    if (!heldButton && sim->millis >= nextButton) {
+      // Browsing only (Up, Down, Menu): OK is only pressed to clear jams, so settings never change
+      const uint8_t buttons[] = {Btn_Up, Btn_Down, Btn_Menu};
+      press(buttons[rng() % 3]);
+      nextButton = sim->millis + (unsigned long)exponential(86400000.0 / std::max(config->buttonsPerDay, 1e-3));
+    }
+    // Someone comes to clear the jam (it may take more than one try)
+    if (wasJammed && !heldButton && sim->millis >= nextJamVisit) {
+      isStuck = false;
+      press(Btn_OK);
+      nextJamVisit = sim->millis + 5000 + (unsigned long)exponential(config->meanRecovery_s * 250);
+    }
+  }
+
+  void press(uint8_t pin) {
+    heldButton = pin;
+    sim->pinLevel[pin] = HIGH;
+    buttonRelease = sim->millis + 80;
+  }
+
+  // Checks what the firmware did on the last pass.
+  void observe() {
+    long rtc = sim->rtcNow;
+    while (nextDue <= rtc) {
+      pending.push_back(nextDue);
+      stats->expected++;
+      nextDue = dueAfter(nextDue + 1);
+    }
+    while (!pending.empty() && rtc - pending.front() > missedAfter_s) {
+      pending.pop_front();
+      stats->missed++;
+    }
+    bool isDispensingNow = isDispensing[0];
+    if (isDispensingNow && !wasDispensing) {
+      stats->dispensed++;
+      if (!pending.empty()) {
+        stats->latencyHistogram[fleetBucket(rtc - pending.front())]++;
+        pending.pop_front();
+      }
+    }
+    wasDispensing = isDispensingNow;
+    bool isJammedNow = doors[0].isJammed();
+    if (isJammedNow && !wasJammed) {
+      stats->jamsDetected++;
+      stats->falseJams += !isStuck;
+      jamStart = sim->millis;
+      nextJamVisit = sim->millis + 5000 + (unsigned long)exponential(config->meanRecovery_s * 1000);
+    }
+    if (!isJammedNow && wasJammed) {
+      uint32_t recovery = (sim->millis - jamStart) / 1000;
+      stats->jamsCleared++;
+      stats->recoveryTotal_s += recovery;
+      stats->recoveryMax_s = std::max(stats->recoveryMax_s, recovery);
+      stats->recoveryHistogram[fleetBucket(recovery)]++;
+    }
+    wasJammed = isJammedNow;
+  }
+
+  // How far (ms) to step before the next pass: finely while the door or a person is doing something,
+  // otherwise straight to the next thing that will happen, on the time task's cadence.
+  unsigned long nextStep(unsigned long end) {
+    if (isMotorOn || doors[0].isDoorMoving()) {
+      return 2;
+    }
+    if (heldButton || (!wasJammed && (wasDispensing || FeedQueue::getDepth() > 0))) {
+      return 10;
+    }
+    unsigned long target = std::min(end, sim->millis + maxSkip_ms);
+    target = std::min(target, std::max(sim->millis + 1, msAt(nextDue)));
+    target = std::min(target, nextButton);
+    if (wasJammed) {
+      target = std::min(target, nextJamVisit);
+    }
+    // The time task runs on the RTC's second while its square wave is running, otherwise on its interval
+    if (TimeMgmt::isSquareWaveRunning()) {
+      return std::max(1UL, msAt(rtcAt(target - 1) + 1) - sim->millis);
+    }
+    unsigned long intervalTime = Tunables::get(TunableId::IntervalTime);
+    unsigned long nextTimeTask = lastTime_ms + intervalTime;
+    while (nextTimeTask < target) {
+      nextTimeTask += intervalTime;
+    }
+    return std::max(1UL, nextTimeTask - sim->millis);
+  }
+};
+
+Device* device;
+
+void onLightDrift(Event) {
+  device->stats->lightDriftWarnings++;
+}
+
+void onAnalogWrite(uint8_t pin, int value) {
+  if (pin == PWM[0]) {
+    device->onMotor(value);
+  }
+}
+
+} // namespace
+
+extern "C" void fleetRunDevice(const DeviceConfig* config, DeviceStats* stats) {
+  Device d;
+  device = &d;
+  d.config = config;
+  d.stats = stats;
+  d.rng.seed(config->seed);
+  // Somewhere in 2026, at a random time of day
+  d.rtcStart = simDayNumber(2026, 1, 1) * 86400L + (long)(d.uniform() * 365 * 86400);
+  d.nextDue = d.dueAfter(d.rtcStart);
+  d.nextButton = (unsigned long)d.exponential(86400000.0 / std::max(config->buttonsPerDay, 1e-3));
+  sim->echoSerial = false;
+  sim->onAnalogWrite = onAnalogWrite;
+  sim->rtcNow = d.rtcStart;
+  d.updateInputs();
+  setup();
+
+  ScheduleEdit edits[fleetMaxTimes];
+  uint8_t results[fleetMaxTimes];
+  for (int i = 0; i < config->timeCount; i++) {
+    edits[i] = { ScheduleEditOp::Add, 0, TimeValue(config->hours[i], config->minutes[i], 0), Recurrence::daily() };
+  }
+  TimeMgmt::applyScheduleBatch(doors[0].getScheduleId(), edits, config->timeCount, results);
+  FeedQueue::setStalePolicy((FeedStalePolicy)config->stalePolicy, config->maxAge_s);
+  EventBus::subscribe(EventType::LightDrift, onLightDrift);
+  Tunables::set(TunableId::JamRetries, config->maxRetries);
+  Tunables::set(TunableId::JamRetryDelay, config->retryDelay_s);
+
+  unsigned long end = config->days * 86400000UL;
+  while (sim->millis < end) {
+    d.updateInputs();
+    unsigned long busy_us = sim->busy_us;
+    loop();
+    stats->loopPasses++;
+    // The clock only moves in delay(), so a pass is timed by what it spent on the hardware
+    stats->loopHistogram[fleetBucket(sim->busy_us - busy_us)]++;
+    d.observe();
+    sim->millis += d.nextStep(end);
+    sim->serialOut.clear();
+  }
+  const JamStats& jams = DoorMgmt::getJamStats();
+  stats->retries = jams.retries;
+  stats->autoCleared = jams.autoCleared;
+  stats->escalated = jams.escalated;
+  // Feedings still waiting at the end only count as missed if they were already overdue
+  for (long due : d.pending) {
+    stats->missed += sim->rtcNow - due > missedAfter_s;
+  }
+}
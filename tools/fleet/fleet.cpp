@@ -0,0 +1,284 @@
+// Runs a fleet of simulated feeders, each with its own random schedule, RTC drift, sensor noise,
+// jams and button presses, across a pool of threads, and reports how the firmware coped: missed
+// feedings, how late feedings started, how long jams took to clear, and how long passes of loop()
+// spent on the hardware.
+//
+// Each device is a fresh copy of the firmware (device.cpp, built with it into fleet_device.so): the
+// firmware keeps its state in globals, so every worker loads its own copy of the library, and reloads
+// it for each device.
+//
+// Usage: fleet [options], see usage() below
+#include "Fleet.h"
+#include <dlfcn.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Options {
+  int devices = 64, days = 7, threads = 0;
+  uint32_t seed = 1;
+  double jamRate = 0.02, maxDriftPpm = 20, maxNoise = 3, meanRecovery_s = 600, buttonsPerDay = 20, maxLightLoss = 0.5;
+  int stalePolicy = 0; // FeedStalePolicy::Merge
+  long maxAge_s = 3600;
+  int maxRetries = 4, retryDelay_s = 30;
+  std::string library;
+};
+
+// Each worker has its own queue of device jobs; a worker that runs out takes from the front of another's.
+struct Worker {
+  std::mutex lock;
+  std::deque<int> jobs;
+};
+
+static Options options;
+static std::vector<DeviceConfig> configs;
+static std::vector<DeviceStats> results;
+static std::vector<Worker> workers;
+static std::atomic<unsigned long> steals(0);
+static std::atomic<bool> isFailed(false);
+
+static void usage() {
+  fprintf(stderr,
+    "usage: fleet [-n devices] [-d days] [-t threads] [-s seed] [-j jam rate] [-p max drift ppm]\n"
+    "             [-e max noise] [-L max light loss 0-1] [-r mean jam recovery s] [-b buttons per day] [-m merge|drop]\n"
+    "             [-a max queued age s] [-R max jam retries] [-D first retry delay s] [-l library]\n");
+  exit(2);
+}
+
+// A random device, drawn from the fleet's seed so a fleet can be run again exactly.
+static DeviceConfig makeConfig(std::mt19937& rng) {
+  std::uniform_real_distribution<double> unit(0, 1);
+  DeviceConfig c = {};
+  c.seed = rng();
+  c.days = options.days;
+  // 1 to 4 feedings a day, at least an hour apart
+  c.timeCount = 1 + rng() % 4;
+  for (int i = 0; i < c.timeCount; i++) {
+    bool isClash;
+    do {
+      c.hours[i] = rng() % 24;
+      c.minutes[i] = rng() % 60;
+      isClash = false;
+      for (int k = 0; k < i; k++) {
+        int apart = abs((c.hours[i] * 60 + c.minutes[i]) - (c.hours[k] * 60 + c.minutes[k]));
+        isClash = isClash || apart < 60 || apart > 1380;
+      }
+    } while (isClash);
+  }
+  c.driftPpm = (unit(rng) * 2 - 1) * options.maxDriftPpm;
+  c.noise = unit(rng) * options.maxNoise;
+  c.lightLoss = unit(rng) * options.maxLightLoss;
+  c.jamRate = options.jamRate;
+  c.meanRecovery_s = options.meanRecovery_s;
+  c.buttonsPerDay = options.buttonsPerDay;
+  c.stalePolicy = options.stalePolicy;
+  c.maxAge_s = options.maxAge_s;
+  c.maxRetries = options.maxRetries;
+  c.retryDelay_s = options.retryDelay_s;
+  return c;
+}
+
+static bool takeJob(int self, int* job) {
+  {
+    std::lock_guard<std::mutex> guard(workers[self].lock);
+    if (!workers[self].jobs.empty()) {
+      *job = workers[self].jobs.back();
+      workers[self].jobs.pop_back();
+      return true;
+    }
+  }
+  for (size_t n = 1; n < workers.size(); n++) {
+    Worker& victim = workers[(self + n) % workers.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (!victim.jobs.empty()) {
+      *job = victim.jobs.front();
+      victim.jobs.pop_front();
+      steals++;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void work(int self) {
+  // dlopen() hands back the already loaded library for a path it has seen, so each worker needs
+  // its own copy of the file.
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/fleet_device_%d_%d.so", (int)getpid(), self);
+  std::string copy = "cp '" + options.library + "' " + path;
+  if (system(copy.c_str()) != 0) {
+    fprintf(stderr, "can't copy %s\n", options.library.c_str());
+    isFailed = true;
+    return;
+  }
+  int job;
+  while (!isFailed && takeJob(self, &job)) {
+    void* library = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    FleetRunDevice run = library ? (FleetRunDevice)dlsym(library, "fleetRunDevice") : nullptr;
+    if (!run) {
+      fprintf(stderr, "can't load %s: %s\n", path, dlerror());
+      isFailed = true;
+      break;
+    }
+    run(&configs[job], &results[job]);
+    dlclose(library);
+  }
+  unlink(path);
+}
+
+// Prints a histogram, one line per non-empty bucket.
+static void printHistogram(const char* title, const char* unit, const uint64_t* counts) {
+  uint64_t total = 0;
+  for (int b = 0; b < fleetBuckets; b++) {
+    total += counts[b];
+  }
+  printf("%s\n", title);
+  for (int b = 0; b < fleetBuckets; b++) {
+    if (counts[b] == 0) {
+      continue;
+    }
+    unsigned long low = b == 0 ? 0 : 1UL << (b - 1), high = b == 0 ? 0 : (1UL << b) - 1;
+    char range[32];
+    if (b == fleetBuckets - 1) {
+      snprintf(range, sizeof(range), ">= %lu %s", low, unit);
+    }
+    else {
+      snprintf(range, sizeof(range), "%lu-%lu %s", low, high, unit);
+    }
+    printf("  %16s %12llu  %5.1f%%\n", range, (unsigned long long)counts[b], 100.0 * counts[b] / total);
+  }
+}
+
+// The smallest value (the bucket's top) that at least fraction p of the counts are at or under.
+static unsigned long percentile(const uint64_t* counts, double p) {
+  uint64_t total = 0, seen = 0;
+  for (int b = 0; b < fleetBuckets; b++) {
+    total += counts[b];
+  }
+  for (int b = 0; b < fleetBuckets; b++) {
+    seen += counts[b];
+    if (total > 0 && seen >= ceil(p * total)) {
+      return b == 0 ? 0 : (1UL << b) - 1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "n:d:t:s:j:p:e:L:r:b:m:a:R:D:l:")) != -1) {
+    switch (opt) {
+      case 'n': options.devices = atoi(optarg); break;
+      case 'd': options.days = atoi(optarg); break;
+      case 't': options.threads = atoi(optarg); break;
+      case 's': options.seed = strtoul(optarg, nullptr, 10); break;
+      case 'j': options.jamRate = atof(optarg); break;
+      case 'p': options.maxDriftPpm = atof(optarg); break;
+      case 'e': options.maxNoise = atof(optarg); break;
+      case 'L': options.maxLightLoss = atof(optarg); break;
+      case 'r': options.meanRecovery_s = atof(optarg); break;
+      case 'b': options.buttonsPerDay = atof(optarg); break;
+      case 'm':
+        if (strcmp(optarg, "merge") == 0) options.stalePolicy = 0;
+        else if (strcmp(optarg, "drop") == 0) options.stalePolicy = 1;
+        else usage();
+        break;
+      case 'a': options.maxAge_s = atol(optarg); break;
+      case 'R': options.maxRetries = atoi(optarg); break;
+      case 'D': options.retryDelay_s = atoi(optarg); break;
+      case 'l': options.library = optarg; break;
+      default: usage();
+    }
+  }
+  if (options.devices < 1 || options.days < 1) {
+    usage();
+  }
+  if (options.library.empty()) {
+    // Next to this program
+    std::string self = argv[0];
+    size_t slash = self.rfind('/');
+    options.library = (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/fleet_device.so";
+  }
+  if (options.threads < 1) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  options.threads = std::min(options.threads, options.devices);
+
+  std::mt19937 rng(options.seed);
+  for (int i = 0; i < options.devices; i++) {
+    configs.push_back(makeConfig(rng));
+  }
+  results.assign(options.devices, DeviceStats());
+  // Deal the devices out round-robin; stealing evens out the rest
+  workers = std::vector<Worker>(options.threads);
+  for (int i = 0; i < options.devices; i++) {
+    workers[i % options.threads].jobs.push_back(i);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < options.threads; t++) {
+    threads.emplace_back(work, t);
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (isFailed) {
+    return 1;
+  }
+
+  DeviceStats total = {};
+  uint64_t latency[fleetBuckets] = {}, recovery[fleetBuckets] = {};
+  int devicesMissing = 0;
+  for (const DeviceStats& s : results) {
+    total.expected += s.expected;
+    total.dispensed += s.dispensed;
+    total.missed += s.missed;
+    total.jamsInjected += s.jamsInjected;
+    total.jamsDetected += s.jamsDetected;
+    total.jamsCleared += s.jamsCleared;
+    total.falseJams += s.falseJams;
+    total.lightDriftWarnings += s.lightDriftWarnings;
+    total.retries += s.retries;
+    total.autoCleared += s.autoCleared;
+    total.escalated += s.escalated;
+    total.recoveryTotal_s += s.recoveryTotal_s;
+    total.recoveryMax_s = std::max(total.recoveryMax_s, s.recoveryMax_s);
+    total.loopPasses += s.loopPasses;
+    for (int b = 0; b < fleetBuckets; b++) {
+      total.loopHistogram[b] += s.loopHistogram[b];
+      latency[b] += s.latencyHistogram[b];
+      recovery[b] += s.recoveryHistogram[b];
+    }
+    devicesMissing += s.missed > 0;
+  }
+
+  printf("%d devices x %d days on %d threads in %.1f s (%lu steals), seed %u, %s stale feedings after %ld s\n",
+    options.devices, options.days, options.threads, wall_s, steals.load(), options.seed,
+    options.stalePolicy == 0 ? "merging" : "dropping", options.maxAge_s);
+  printf("Feedings: %u scheduled, %u dispensed, %u missed (%.2f%%, on %d devices)\n", total.expected,
+    total.dispensed, total.missed, total.expected ? 100.0 * total.missed / total.expected : 0.0, devicesMissing);
+  printf("Jams: %u injected, %u detected (%u false), %u cleared; recovery mean %.0f s, p50 <= %lu s, p95 <= %lu s, max %u s\n",
+    total.jamsInjected, total.jamsDetected, total.falseJams, total.jamsCleared,
+    total.jamsCleared ? (double)total.recoveryTotal_s / total.jamsCleared : 0.0,
+    percentile(recovery, 0.5), percentile(recovery, 0.95), total.recoveryMax_s);
+  printf("Jam retries (up to %d, from %d s): %u made, %u jams cleared by one, %u left to the operator\n",
+    options.maxRetries, options.retryDelay_s, total.retries, total.autoCleared, total.escalated);
+  printf("Light drift warnings: %u\n", total.lightDriftWarnings);
+  printf("Loop passes: %llu\n", (unsigned long long)total.loopPasses);
+  printHistogram("Loop pass hardware time:", "us", total.loopHistogram);
+  printHistogram("Feeding start latency:", "s", latency);
+  printHistogram("Jam recovery:", "s", recovery);
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Host stand-in for the Arduino core, so the firmware can be built and run on a PC
+// against the simulated hardware in HostHardware.h. Only what the firmware uses is provided.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+// Host code uses these, and they have to come before the min/max macros below
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define SDA 18
+#define SCL 19
+#define PROGMEM
+#define PGM_P const char*
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define PSTR(x) (x)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+// As on the AVR, F() strings are their own type, so only what takes them can print them
+class __FlashStringHelper;
+#define F(x) (reinterpret_cast<const __FlashStringHelper*>(x))
+#define _BV(b) (1 << (b))
+// Reset flags (MCUSR)
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+extern uint8_t MCUSR;
+// Pin change interrupts: the control and flag registers (one bit per port), and each port's mask
+extern uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+// As in the Uno's pins_arduino.h: pins 0 - 7 are port D (PCINT2), 8 - 13 port B (PCINT0), A0 - A5 port C (PCINT1)
+#define digitalPinToPCICR(p) (((p) >= 0 && (p) <= 21) ? (&PCICR) : ((uint8_t*)0))
+#define digitalPinToPCICRbit(p) (((p) <= 7) ? 2 : (((p) <= 13) ? 0 : 1))
+#define digitalPinToPCMSK(p) (((p) <= 7) ? (&PCMSK2) : (((p) <= 13) ? (&PCMSK0) : (((p) <= 21) ? (&PCMSK1) : ((uint8_t*)0))))
+#define digitalPinToPCMSKbit(p) (((p) <= 7) ? (p) : (((p) <= 13) ? ((p) - 8) : ((p) - 14)))
+
+#include "binary.h"
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class String {
+  public:
+    std::string s;
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const __FlashStringHelper* f) : String(reinterpret_cast<const char*>(f)) {}
+    String(const std::string& x) : s(x) {}
+    explicit String(char c) : s(1, c) {}
+    explicit String(int v) : s(std::to_string(v)) {}
+    explicit String(unsigned v) : s(std::to_string(v)) {}
+    explicit String(long v) : s(std::to_string(v)) {}
+    explicit String(unsigned long v) : s(std::to_string(v)) {}
+    explicit String(unsigned char v) : s(std::to_string(v)) {}
+    explicit String(double v) : s(std::to_string(v)) {}
+    unsigned int length() const { return s.size(); }
+    char operator[](unsigned i) const { return i < s.size() ? s[i] : 0; }
+    const char* c_str() const { return s.c_str(); }
+    String& operator+=(const String& o) { s += o.s; return *this; }
+    String& operator+=(const char* o) { s += o; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(const __FlashStringHelper* f) { s += reinterpret_cast<const char*>(f); return *this; }
+    bool operator==(const String& o) const { return s == o.s; }
+    long toInt() const { return atol(s.c_str()); }
+};
+inline String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+inline String operator+(const String& a, const char* b) { return String(a.s + b); }
+inline String operator+(const char* a, const String& b) { return String(a + b.s); }
+inline String operator+(const String& a, char c) { return String(a.s + c); }
+inline String operator+(const String& a, const __FlashStringHelper* f) { return a + reinterpret_cast<const char*>(f); }
+
+class Print {
+  public:
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* b, size_t n) { size_t r = 0; while (n--) r += write(*b++); return r; }
+    size_t print(const char* c) { return write((const uint8_t*)c, strlen(c)); }
+    size_t print(const String& c) { return print(c.c_str()); }
+    size_t print(const __FlashStringHelper* f) { return print(reinterpret_cast<const char*>(f)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(unsigned char v, int = 10) { return print(String((unsigned)v)); }
+    size_t println() { return print("\n"); }
+    template <class T> size_t println(T v) { return print(v) + println(); }
+    virtual ~Print() {}
+};
+
+class HardwareSerial : public Print {
+  public:
+    void begin(unsigned long baud);
+    int available();
+    int read();
+    int peek();
+    long parseInt();
+    size_t write(uint8_t c) override;
+    using Print::write;
+    int availableForWrite() { return 63; }
+    void flush() {}
+    operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,21 @@
+// Host stand-in for the EEPROM library, backed by the simulated EEPROM (sim->eeprom, erased to 0xFF).
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include "HostHardware.h"
+
+class EEPROMClass {
+  public:
+    uint8_t read(int address) { return sim->eeprom[address]; }
+    void write(int address, uint8_t value) { sim->eeprom[address] = value; sim->eepromWrites++; }
+    void update(int address, uint8_t value) { if (read(address) != value) write(address, value); }
+    template <class T> T& get(int address, T& t) { memcpy(&t, &sim->eeprom[address], sizeof(T)); return t; }
+    template <class T> const T& put(int address, const T& t) {
+      for (size_t i = 0; i < sizeof(T); i++) update(address + i, ((const uint8_t*)&t)[i]);
+      return t;
+    }
+    uint16_t length() { return sizeof(sim->eeprom); }
+};
+static EEPROMClass EEPROM;
+
+#endif
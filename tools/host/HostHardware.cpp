@@ -0,0 +1,327 @@
+#include "HostHardware.h"
+#include "Wire.h"
+#include <stdio.h>
+
+static SimHardware defaultHardware;
+SimHardware* sim = &defaultHardware;
+
+HardwareSerial Serial;
+TwoWire Wire;
+uint8_t MCUSR = 0;
+uint8_t PCICR = 0, PCIFR = 0, PCMSK0 = 0, PCMSK1 = 0, PCMSK2 = 0;
+// The firmware's pin change interrupt for A0 - A5, if it has one
+void PCINT1_vect_host() __attribute__((weak));
+
+SimHardware::SimHardware() {
+  memset(eeprom, 0xFF, sizeof(eeprom));
+  memset(lcd, ' ', sizeof(lcd));
+  for (uint8_t r = 0; r < 4; r++) {
+    lcd[r][20] = '\0';
+  }
+}
+
+void SimHardware::printLcd() {
+  printf("+--------------------+\n");
+  for (uint8_t r = 0; r < 4; r++) {
+    printf("|%s|\n", lcd[r]);
+  }
+  printf("+--------------------+\n");
+}
+
+// Days from civil date, after Howard Hinnant's algorithm, shifted so that 2000-01-01 is day 0.
+long simDayNumber(int year, int month, int day) {
+  year -= month <= 2;
+  long era = (year >= 0 ? year : year - 399) / 400;
+  long yoe = year - era * 400;
+  long doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 730425;
+}
+
+void simCivilDate(long dayNumber, int* year, int* month, int* day) {
+  long z = dayNumber + 730425;
+  long era = (z >= 0 ? z : z - 146096) / 146097;
+  long doe = z - era * 146097;
+  long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  long mp = (5 * doy + 2) / 153;
+  *day = doy - (153 * mp + 2) / 5 + 1;
+  *month = mp < 10 ? mp + 3 : mp - 9;
+  *year = yoe + era * 400 + (*month <= 2);
+}
+
+// The DS3231's square wave, while it is set to 1 Hz (INTCN and RS2:RS1 clear): a falling edge each
+// time its second ticks over, and a rising edge half way through. Edges are delivered when the firmware
+// next reads the clock (both at once, as the sim has no sub-second time), to the pin change interrupt
+// if it is enabled for sqwPin. A jump back or of more than a day (a tool setting rtcNow) has no edges.
+static void simSquareWave() {
+  static bool isInside = false;
+  long now = sim->rtcNow;
+  if (now < sim->sqwLast || now - sim->sqwLast > 86400 || (sim->rtcControl & 0x1C) != 0 || !sim->rtcRunning) {
+    sim->sqwLast = now;
+    return;
+  }
+  if (isInside) {
+    return; // Called from the interrupt itself
+  }
+  isInside = true;
+  bool isEnabled = sim->sqwPin >= A0 && (PCICR & _BV(1)) && (PCMSK1 & _BV(sim->sqwPin - A0)) && PCINT1_vect_host;
+  for (; sim->sqwLast < now; sim->sqwLast++) {
+    sim->pinLevel[sim->sqwPin] = LOW;
+    if (isEnabled) PCINT1_vect_host();
+    sim->pinLevel[sim->sqwPin] = HIGH;
+    if (isEnabled) PCINT1_vect_host();
+  }
+  isInside = false;
+}
+
+#pragma region Arduino_Core
+unsigned long millis() {
+  simSquareWave();
+  return sim->millis;
+}
+unsigned long micros() { return sim->millis * 1000; }
+void delay(unsigned long ms) { sim->millis += ms; }
+void delayMicroseconds(unsigned int) {}
+void pinMode(uint8_t, uint8_t) {}
+int digitalRead(uint8_t pin) { return pin < simPinCount ? sim->pinLevel[pin] : LOW; }
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < simPinCount) sim->pinLevel[pin] = value;
+}
+int analogRead(uint8_t pin) {
+  sim->busy_us += 112; // 13 ADC clocks at 125 kHz, and the call
+  if (pin >= simPinCount) return 0;
+  if (!sim->analogQueue[pin].empty()) {
+    int v = sim->analogQueue[pin].front();
+    sim->analogQueue[pin].pop_front();
+    return v;
+  }
+  return sim->analogIn[pin];
+}
+void analogWrite(uint8_t pin, int value) {
+  if (pin < simPinCount) sim->analogOut[pin] = value;
+  if (sim->onAnalogWrite) sim->onAnalogWrite(pin, value);
+}
+
+int HardwareSerial::available() { return sim->serialIn.size(); }
+int HardwareSerial::read() {
+  if (sim->serialIn.empty()) return -1;
+  int c = (uint8_t)sim->serialIn[0];
+  sim->serialIn.erase(0, 1);
+  return c;
+}
+int HardwareSerial::peek() { return sim->serialIn.empty() ? -1 : (uint8_t)sim->serialIn[0]; }
+long HardwareSerial::parseInt() {
+  size_t used = 0;
+  long v = 0;
+  try { v = std::stol(sim->serialIn, &used); } catch (...) {}
+  sim->serialIn.erase(0, used);
+  return v;
+}
+void HardwareSerial::begin(unsigned long baud) { sim->serialBaud = baud; }
+// The UART sends 10 bits a byte from a 64-byte buffer. A write only waits once the buffer is full.
+size_t HardwareSerial::write(uint8_t c) {
+  unsigned long now_us = sim->millis * 1000, byte_us = 10000000UL / sim->serialBaud;
+  sim->serialSent_us = (sim->serialSent_us > now_us ? sim->serialSent_us : now_us) + byte_us;
+  if (sim->serialSent_us - now_us > 64 * byte_us) {
+    sim->busy_us += byte_us;
+  }
+  if (sim->echoSerial) putchar(c);
+  else sim->serialOut += (char)c;
+  return 1;
+}
+#pragma endregion Arduino_Core
+
+#pragma region RTC
+// Splits the simulated clock into date and time, and puts them back together after a field changes.
+struct SimDateTime {
+  int year, month, day, hours, minutes, seconds;
+  SimDateTime() {
+    long secondOfDay = sim->rtcNow % 86400;
+    simCivilDate(sim->rtcNow / 86400, &year, &month, &day);
+    hours = secondOfDay / 3600;
+    minutes = secondOfDay / 60 % 60;
+    seconds = secondOfDay % 60;
+  }
+  // Writing the time restarts the RTC's second, so the square wave starts over from it
+  void save() {
+    sim->rtcNow = simDayNumber(year, month, day) * 86400 + hours * 3600L + minutes * 60 + seconds;
+    sim->sqwLast = sim->rtcNow;
+  }
+};
+
+#pragma endregion RTC
+
+#pragma region LCD
+// The HD44780 behind the PCF8574 backpack, as far as the firmware drives it: it latches D4 - D7 (and RS)
+// when E goes from high to low, starting in 8-bit mode until told to use 4 bits.
+static void lcdByte(uint8_t value, bool isData) {
+  if (!isData) {
+    if (value == 0x01) { // Clear
+      for (uint8_t r = 0; r < 4; r++) memset(sim->lcd[r], ' ', 20);
+      sim->lcdCol = sim->lcdRow = 0;
+      sim->lcdIsCgram = false;
+    }
+    else if (value & 0x80) { // Set DDRAM address
+      const uint8_t rowStart[] = {0x00, 0x40, 0x14, 0x54};
+      uint8_t addr = value & 0x7F;
+      sim->lcdIsCgram = false;
+      for (uint8_t r = 0; r < 4; r++) {
+        if (addr >= rowStart[r] && addr < rowStart[r] + 20) {
+          sim->lcdRow = r;
+          sim->lcdCol = addr - rowStart[r];
+        }
+      }
+    }
+    else if (value & 0x40) { // Set CGRAM address: custom character data follows
+      sim->lcdIsCgram = true;
+    }
+    else if ((value & 0xF0) == 0x20) { // Function set
+      sim->lcdIs4Bit = true;
+    }
+    return;
+  }
+  if (sim->lcdIsCgram) return;
+  // The custom characters are the up and down arrows
+  if (value == 0) value = '^';
+  else if (value == 1) value = 'v';
+  if (sim->lcdRow < 4 && sim->lcdCol < 20) {
+    sim->lcd[sim->lcdRow][sim->lcdCol] = value;
+  }
+  sim->lcdCol++;
+}
+
+static void lcdExpanderWrite(uint8_t state) {
+  bool isLatched = (sim->lcdLastState & 0x04) && !(state & 0x04);
+  sim->lcdLastState = state;
+  if (!isLatched) return;
+  uint8_t nibble = state & 0xF0;
+  bool isData = state & 0x01;
+  if (!sim->lcdIs4Bit) {
+    lcdByte(nibble, isData); // 8-bit mode: D0 - D3 aren't wired, so they read as 0
+    sim->lcdHasHighNibble = false;
+  }
+  else if (!sim->lcdHasHighNibble) {
+    sim->lcdHighNibble = nibble;
+    sim->lcdHasHighNibble = true;
+  }
+  else {
+    lcdByte(sim->lcdHighNibble | nibble >> 4, isData);
+    sim->lcdHasHighNibble = false;
+  }
+}
+#pragma endregion LCD
+
+#pragma region Wire
+static uint8_t toBcd(int v) {
+  return (v / 10) << 4 | (v % 10);
+}
+
+void TwoWire::setClock(uint32_t clock) { sim->i2cClock = clock; }
+// Each byte on the bus is 9 clocks: 8 bits and the acknowledge
+static void i2cCharge(unsigned long bytes) {
+  sim->busy_us += bytes * 9000000UL / sim->i2cClock;
+}
+bool TwoWire::getWireTimeoutFlag() { return sim->i2cTimeoutFlag; }
+void TwoWire::clearWireTimeoutFlag() { sim->i2cTimeoutFlag = false; }
+void TwoWire::beginTransmission(uint8_t address) {
+  i2cCharge(1); // The address
+  this->address = address;
+  isFirstByte = true;
+  txCount = 0;
+}
+size_t TwoWire::write(uint8_t data) {
+  // The first byte sent to the DS3231 sets its register pointer, and the rest are written from there
+  if (isFirstByte && address == 0x68) {
+    reg = data;
+  }
+  else if (address == 0x68 && txCount < sizeof(tx)) {
+    tx[txCount++] = data;
+  }
+  if (address == 0x27) {
+    lcdExpanderWrite(data);
+  }
+  isFirstByte = false;
+  sim->i2cBytes++;
+  i2cCharge(1);
+  return 1;
+}
+size_t TwoWire::write(const uint8_t* data, size_t n) {
+  for (size_t i = 0; i < n; i++) write(data[i]);
+  return n;
+}
+// The DS3231's registers 0 - 6: seconds, minutes, hours (24 h), day of week, date, month, year
+static void rtcTimeRegisters(uint8_t* regs) {
+  SimDateTime t;
+  uint8_t r[7] = { toBcd(t.seconds), toBcd(t.minutes), toBcd(t.hours),
+    (uint8_t)((sim->rtcNow / 86400 + 5) % 7 + 1), toBcd(t.day), toBcd(t.month), toBcd(t.year % 100) };
+  memcpy(regs, r, sizeof(r));
+}
+static int fromBcd(uint8_t v) {
+  return (v >> 4) * 10 + (v & 0x0F);
+}
+
+uint8_t TwoWire::endTransmission(bool) {
+  sim->i2cTransactions++;
+  if (sim->i2cStuck) {
+    sim->i2cTimeoutFlag = true;
+    return 5; // Timeout
+  }
+  if (address == 0x68 && txCount > 0) {
+    uint8_t regs[7];
+    bool isTimeWritten = false;
+    rtcTimeRegisters(regs);
+    for (uint8_t i = 0; i < txCount; i++) {
+      uint8_t r = reg + i;
+      if (r < 7) {
+        regs[r] = tx[i];
+        isTimeWritten = true;
+      }
+      else if (r == 0x0E) {
+        sim->rtcControl = tx[i] & ~0x20; // The temperature conversion it starts is over at once
+      }
+      else if (r == 0x0F && !(tx[i] & 0x80)) {
+        sim->rtcRunning = true; // The oscillator-stopped flag can only be cleared
+      }
+      else if (r == 0x10) {
+        sim->rtcAging = (int8_t)tx[i];
+      }
+    }
+    if (isTimeWritten) {
+      SimDateTime t;
+      t.seconds = fromBcd(regs[0] & 0x7F);
+      t.minutes = fromBcd(regs[1] & 0x7F);
+      t.hours = fromBcd(regs[2] & 0x3F);
+      t.day = fromBcd(regs[4] & 0x3F);
+      t.month = fromBcd(regs[5] & 0x1F);
+      t.year = 2000 + fromBcd(regs[6]);
+      t.save();
+      sim->rtcWrites++;
+    }
+  }
+  return 0;
+}
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t n, uint8_t) {
+  sim->i2cTransactions++;
+  i2cCharge(1 + n); // The address, then the bytes read
+  rxCount = rxIndex = 0;
+  if (sim->i2cStuck) {
+    sim->i2cTimeoutFlag = true;
+    return 0;
+  }
+  if (address != 0x68) {
+    return 0;
+  }
+  uint8_t regs[7];
+  rtcTimeRegisters(regs);
+  for (; rxCount < n && rxCount < sizeof(rx); rxCount++) {
+    uint8_t r = reg + rxCount;
+    rx[rxCount] = r < 7 ? regs[r] : r == 0x0E ? sim->rtcControl : r == 0x0F ? (sim->rtcRunning ? 0 : 0x80)
+      : r == 0x10 ? (uint8_t)sim->rtcAging : 0;
+  }
+  return rxCount;
+}
+int TwoWire::available() { return rxCount - rxIndex; }
+int TwoWire::read() { return rxIndex < rxCount ? rx[rxIndex++] : -1; }
+#pragma endregion Wire
+
@@ -0,0 +1,71 @@
+// Simulated hardware for running the firmware on a PC: the clock, pins, ADC, RTC, LCD, EEPROM and Serial.
+// Tools set inputs (e.g. analogIn, rtcNow) and read outputs (e.g. lcd) through `sim`.
+#ifndef HOST_HARDWARE_H
+#define HOST_HARDWARE_H
+
+#include "Arduino.h"
+#include <deque>
+#include <string>
+
+const static uint8_t simPinCount = 20;
+
+struct SimHardware {
+  unsigned long millis = 0;
+  // Time (us) the firmware has spent on the hardware since the start: I2C transfers at the bus clock,
+  // ADC conversions, and Serial output once its buffer is full. Counted, but doesn't move the clock.
+  unsigned long busy_us = 0;
+  uint32_t i2cClock = 100000;
+  unsigned long serialBaud = 9600;
+  // When (us of millis) the UART will have sent everything written so far
+  unsigned long serialSent_us = 0;
+  // The RTC: # of seconds since 2000-01-01
+  long rtcNow = 0;
+  // False while the DS3231's oscillator-stopped flag is set (it lost the time), until the firmware clears it
+  bool rtcRunning = true;
+  // The DS3231's control and aging offset registers, and the # of times its time registers were written
+  uint8_t rtcControl = 0x1C;
+  int8_t rtcAging = 0;
+  unsigned long rtcWrites = 0;
+  // The pin the DS3231's SQW output is wired to, and the RTC's time as of its last falling edge there
+  uint8_t sqwPin = A3;
+  long sqwLast = 0;
+  // While true, every I2C transaction times out (a device holding the bus)
+  bool i2cStuck = false;
+  bool i2cTimeoutFlag = false;
+  // # of I2C transactions, and of bytes written, since the start
+  unsigned long i2cTransactions = 0, i2cBytes = 0;
+  uint8_t pinLevel[simPinCount] = {};
+  // analogRead() returns the front of analogQueue (if any), otherwise analogIn
+  int analogIn[simPinCount] = {};
+  std::deque<int> analogQueue[simPinCount];
+  int analogOut[simPinCount] = {};
+  // Called on every analogWrite(), if set
+  void (*onAnalogWrite)(uint8_t pin, int value) = nullptr;
+  // The 20x4 LCD, and its cursor
+  char lcd[4][21];
+  uint8_t lcdCol = 0, lcdRow = 0;
+  // The LCD controller's state: 4-bit mode, the first nibble of a byte, writing custom characters,
+  // and the backpack's last output
+  bool lcdIs4Bit = false, lcdHasHighNibble = false, lcdIsCgram = false;
+  uint8_t lcdHighNibble = 0, lcdLastState = 0;
+  // The EEPROM (1 KB, as on the Uno), and the # of bytes written to it since the start
+  uint8_t eeprom[1024];
+  unsigned long eepromWrites = 0;
+  // Serial input not yet read, and whether Serial output is printed (otherwise it's kept in serialOut)
+  std::string serialIn;
+  bool echoSerial = true;
+  std::string serialOut;
+
+  SimHardware();
+  // Prints the LCD's contents with a border.
+  void printLcd();
+};
+
+// The hardware the firmware is running against.
+extern SimHardware* sim;
+
+// Calendar helpers (proleptic Gregorian, day 0 = 2000-01-01)
+long simDayNumber(int year, int month, int day);
+void simCivilDate(long dayNumber, int* year, int* month, int* day);
+
+#endif
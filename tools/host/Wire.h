@@ -0,0 +1,30 @@
+// Host stand-in for Wire, with the devices on the bus simulated (see HostHardware.h): the DS3231's time,
+// control and aging offset registers can be read and written, and writes to the LCD backpack (0x27)
+// drive the simulated screen. Any other device just acknowledges.
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire {
+  public:
+    void begin() {}
+    void setClock(uint32_t clock);
+    void setWireTimeout(uint32_t = 25000, bool = false) {}
+    bool getWireTimeoutFlag();
+    void clearWireTimeoutFlag();
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t n);
+    uint8_t endTransmission(bool = true);
+    uint8_t requestFrom(uint8_t address, uint8_t n, uint8_t = 1);
+    int available();
+    int read();
+    void end() {}
+  private:
+    uint8_t address = 0, reg = 0, rx[32] = {}, rxCount = 0, rxIndex = 0, tx[32] = {}, txCount = 0;
+    bool isFirstByte = false;
+};
+extern TwoWire Wire;
+
+#endif
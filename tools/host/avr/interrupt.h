@@ -0,0 +1,10 @@
+// Host stand-in for avr/interrupt.h. An ISR becomes a plain function, <vector>_host(), which the
+// simulated hardware calls when the interrupt would fire.
+#ifndef HOST_INTERRUPT_H
+#define HOST_INTERRUPT_H
+
+#define ISR(vector) void vector##_host()
+inline void cli() {}
+inline void sei() {}
+
+#endif
@@ -0,0 +1,11 @@
+// Host stand-in for avr/wdt.h. There is no watchdog on the PC.
+#ifndef HOST_WDT_H
+#define HOST_WDT_H
+
+#define WDTO_15MS 0
+#define WDTO_2S 7
+inline void wdt_enable(int) {}
+inline void wdt_reset() {}
+inline void wdt_disable() {}
+
+#endif
@@ -0,0 +1,320 @@
+// Replays a trace dumped by the firmware's Trace recorder (send a 't' line over Serial) on a PC.
+// Button presses go through the event bus to SystemUI::Input and DoorMgmt, door ticks through
+// DoorMgmt::ClockTick, time ticks through TimeMgmt::Tick and timer runs through Timers::Poll, against simulated hardware fed with
+// the traced RTC and ADC readings. Motor commands are checked against the trace, and the timing
+// of each task is profiled. The doors are taken to be idle (or homing) when the trace starts, so
+// a trace that has wrapped may show a few mismatches at first.
+//
+// Usage: replay [-v] trace.txt
+#include <Arduino.h>
+#include "HostHardware.h"
+#include "EventBus.h"
+#include "FeedQueue.h"
+#include "DoorMgmt.h"
+#include "SystemUI.h"
+#include "TimeMgmt.h"
+#include "Trace.h"
+#include "Timers.h"
+#include "Tunables.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Same pins as SWE6823_Project.ino. The sketch has one schedule per door, so the # of doors
+// is taken from the # of schedules in the trace.
+const static uint8_t maxDoors = 2;
+static uint8_t doorCount = 1;
+const static uint8_t
+  Direction[] = {12, 13}, PWM[] = {3, 11}, Brake[] = {9, 8},
+  Photoresistor[] = {A1, A2}, CurrentSense[] = {A0, DoorMgmt::noSensePin};
+const static char* const scheduleNames[] = {"Pet 1", "Pet 2", "Pet 3"};
+// Nominal interval of each traced task (ms), by TraceTask, from the traced tunables
+static unsigned long taskInterval[2];
+const static char* const taskNames[] = {"Time", "Door"};
+const static char* const buttonNames[] = {"Up", "Down", "OK", "Menu"};
+
+struct Record {
+  unsigned long time; // Unwrapped millis()
+  TraceType type;
+  uint8_t arg;
+  uint16_t value;
+};
+
+struct MotorCommand {
+  uint8_t door;
+  bool isOpening;
+  int duty;
+};
+
+static DoorMgmt doors[maxDoors];
+static std::vector<MotorCommand> motorCommands;
+
+// Timing of each traced task
+struct TaskProfile {
+  unsigned long runs = 0, late = 0, gaps = 0, maxGap = 0, totalGap = 0, lastRun = 0;
+};
+static TaskProfile profiles[2];
+static unsigned long buttons = 0, stalls = 0;
+
+static void onAnalogWrite(uint8_t pin, int value) {
+  for (uint8_t i = 0; i < doorCount; i++) {
+    if (PWM[i] == pin) {
+      motorCommands.push_back({ i, sim->pinLevel[Direction[i]] == HIGH, value });
+    }
+  }
+}
+
+static bool isDriver(const Record& r) {
+  return r.type == TraceType::Task || r.type == TraceType::Button
+    || (r.type == TraceType::Adc && (r.arg & 0x80));
+}
+
+// Reads a trace from f. Returns false if it isn't a trace, or has a schedule time out of range.
+static bool readTrace(FILE* f, uint8_t* scheduleCount, std::vector<ScheduleEdit>* edits,
+    std::vector<uint8_t>* editSchedules, std::vector<Record>* records) {
+  char line[128];
+  bool isStarted = false;
+  unsigned long time = 0;
+  uint16_t lastTime16 = 0;
+  while (fgets(line, sizeof(line), f)) {
+    unsigned a, b, c, d, e, g;
+    if (!isStarted) {
+      isStarted = sscanf(line, "TRACE %u %u", &a, &b) == 2;
+      *scheduleCount = isStarted ? b : 0;
+      continue;
+    }
+    if (strncmp(line, "END", 3) == 0) {
+      return true;
+    }
+    if (sscanf(line, "S %u %u %u %u %u %u", &a, &b, &c, &d, &e, &g) == 6) {
+      // Checked before packing, as TimeValue would carry e.g. 75 minutes into the hour
+      if (b > 255 || c > 255 || d > 255 || !TimeValue::isValid(b, c, d)) {
+        fprintf(stderr, "Bad schedule time: %s", line);
+        return false;
+      }
+      ScheduleEdit edit = { ScheduleEditOp::Add, 0, TimeValue(b, c, d), Recurrence::daily() };
+      edit.rule.days = e;
+      edit.rule.anchorDay = g;
+      edits->push_back(edit);
+      editSchedules->push_back(a);
+    }
+    else if (sscanf(line, "P %u %u", &a, &b) == 2) {
+      Tunables::set((TunableId)a, b);
+    }
+    else if (sscanf(line, "R %u %u %u %u", &a, &b, &c, &d) == 4) {
+      // Only the low 16 bits of millis() are kept; records are never more than ~1 s apart.
+      time += records->empty() ? a : (uint16_t)(a - lastTime16);
+      lastTime16 = a;
+      records->push_back({ time, (TraceType)b, (uint8_t)c, (uint16_t)d });
+    }
+  }
+  return isStarted;
+}
+
+static void setup(uint8_t scheduleCount, const std::vector<ScheduleEdit>& edits,
+    const std::vector<uint8_t>& editSchedules) {
+  sim->onAnalogWrite = onAnalogWrite;
+  sim->echoSerial = false;
+  EventBus::Init();
+  Timers::Init();
+  FeedQueue::Init();
+  for (uint8_t i = 0; i < doorCount; i++) {
+    doors[i].Init(i, Direction[i], PWM[i], Brake[i], Photoresistor[i], CurrentSense[i]);
+  }
+  SystemUI::Init(false, "replay");
+  TimeMgmt::Init();
+  for (uint8_t i = 0; i < scheduleCount && i < TimeMgmt::maxSchedules; i++) {
+    uint8_t sched = TimeMgmt::addSchedule(scheduleNames[i]);
+    if (i < doorCount) {
+      doors[i].bindSchedule(sched);
+    }
+  }
+  for (size_t i = 0; i < edits.size(); i++) {
+    uint8_t result;
+    TimeMgmt::applyScheduleBatch(editSchedules[i], &edits[i], 1, &result);
+  }
+  EventBus::Dispatch();
+  motorCommands.clear();
+}
+
+// Runs one traced task, button press or stall.
+static void runDriver(const Record& driver, bool isVerbose) {
+  if (driver.type == TraceType::Task && driver.arg < 2) {
+    TaskProfile* p = &profiles[driver.arg];
+    unsigned long gap = driver.time - p->lastRun;
+    // A door tick is only traced while a door is busy, so gaps between busy spells don't count
+    if (p->runs > 0 && (driver.arg == (uint8_t)TraceTask::Time || gap < 1000)) {
+      p->gaps++;
+      p->totalGap += gap;
+      p->maxGap = max(p->maxGap, gap);
+      if (gap > taskInterval[driver.arg] * 3 / 2) {
+        p->late++;
+        printf("%8lu ms  %s task late by %lu ms\n", driver.time, taskNames[driver.arg], gap - taskInterval[driver.arg]);
+      }
+    }
+    p->runs++;
+    p->lastRun = driver.time;
+    if (isVerbose) {
+      printf("%8lu ms  %s task\n", driver.time, taskNames[driver.arg]);
+    }
+    if (driver.arg == (uint8_t)TraceTask::Time) {
+      TimeMgmt::Tick();
+    }
+    else {
+      for (uint8_t d = 0; d < doorCount; d++) {
+        doors[d].ClockTick();
+      }
+    }
+  }
+  else if (driver.type == TraceType::Task && driver.arg == (uint8_t)TraceTask::Timer) {
+    if (isVerbose) {
+      printf("%8lu ms  Timers\n", driver.time);
+    }
+    Timers::Poll();
+  }
+  else if (driver.type == TraceType::Button) {
+    buttons++;
+    printf("%8lu ms  %s pressed\n", driver.time, buttonNames[driver.arg & 3]);
+    EventBus::post(EventType::ButtonPressed, driver.arg);
+  }
+  else if (driver.type == TraceType::Adc) {
+    // Motor current over the stall threshold: hold it there until the door stops.
+    uint8_t d = driver.arg & 0x7F;
+    stalls++;
+    printf("%8lu ms  Door %u stalled (current %u)\n", driver.time, d + 1, driver.value);
+    if (d < doorCount && CurrentSense[d] != DoorMgmt::noSensePin) {
+      sim->analogIn[CurrentSense[d]] = driver.value;
+      for (uint8_t n = 0; n < 255 && doors[d].isDoorMoving(); n++) {
+        doors[d].SenseTick();
+      }
+      sim->analogIn[CurrentSense[d]] = 0;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  bool isVerbose = argc > 2 && strcmp(argv[1], "-v") == 0;
+  FILE* f = argc > 1 ? fopen(argv[argc - 1], "r") : nullptr;
+  if (!f) {
+    fprintf(stderr, "usage: replay [-v] trace.txt\n");
+    return 2;
+  }
+  uint8_t scheduleCount = 0;
+  std::vector<ScheduleEdit> edits;
+  // Defaults for any tunables the trace doesn't have
+  Tunables::Init();
+  std::vector<uint8_t> editSchedules;
+  std::vector<Record> records;
+  if (!readTrace(f, &scheduleCount, &edits, &editSchedules, &records)) {
+    fprintf(stderr, "no valid trace found\n");
+    return 2;
+  }
+  fclose(f);
+
+  // Start the clock from the first time read, so the UI has it before the first task
+  long day = 0;
+  for (const Record& r : records) {
+    if (r.type == TraceType::RtcDay) {
+      day = r.value;
+    }
+    if (r.type == TraceType::RtcRead) {
+      sim->rtcNow = day * 86400 + r.value * 60L + r.arg;
+      break;
+    }
+  }
+  sim->millis = records.empty() ? 0 : records[0].time;
+  doorCount = max(1, min(scheduleCount, maxDoors));
+  taskInterval[(uint8_t)TraceTask::Time] = Tunables::get(TunableId::IntervalTime);
+  taskInterval[(uint8_t)TraceTask::Door] = Tunables::get(TunableId::IntervalDoorCheck);
+  setup(scheduleCount, edits, editSchedules);
+  // Back to the start of the trace, as setup() waits on the LCD and the doors' timers count from here
+  sim->millis = records.empty() ? 0 : records[0].time;
+
+  unsigned long mismatches = 0;
+  size_t i = 0;
+  // Records before the first driver (task, button or stall) have nothing to replay against, except
+  // for the doors homing at boot (a trace that hasn't wrapped starts at boot).
+  for (; i < records.size() && !isDriver(records[i]); i++) {
+    const Record& r = records[i];
+    if (r.type == TraceType::Motor && r.value > 0 && !(r.arg & 0x80) && r.arg < doorCount) {
+      doors[r.arg].homeDoor();
+    }
+  }
+  motorCommands.clear();
+  while (i < records.size()) {
+    // One pass of loop(): the drivers traced at the same time, then the events they posted.
+    unsigned long passTime = records[i].time;
+    std::vector<MotorCommand> expected;
+    motorCommands.clear();
+    sim->millis = passTime;
+    while (i < records.size() && records[i].time == passTime) {
+      const Record& driver = records[i];
+      bool isTimeSet = false;
+      // The records up to the next driver are what happened while it ran: readings to feed back in,
+      // and motor commands to check.
+      size_t j = i + 1;
+      for (; j < records.size() && !isDriver(records[j]); j++) {
+        const Record& r = records[j];
+        switch (r.type) {
+          case TraceType::RtcDay:
+            day = r.value;
+            break;
+          case TraceType::RtcRead:
+            if (!isTimeSet) {
+              sim->rtcNow = day * 86400 + r.value * 60L + r.arg;
+              isTimeSet = true;
+            }
+            break;
+          case TraceType::Adc:
+            if (r.arg < doorCount) {
+              sim->analogQueue[Photoresistor[r.arg]].push_back(r.value);
+            }
+            break;
+          case TraceType::Motor:
+            expected.push_back({ (uint8_t)(r.arg & 0x7F), (r.arg & 0x80) != 0, r.value });
+            break;
+          default:
+            break;
+        }
+      }
+      runDriver(driver, isVerbose);
+      i = j;
+    }
+    EventBus::Dispatch();
+
+    // The doors should have been driven the same way as on the device
+    bool isSame = expected.size() == motorCommands.size();
+    for (size_t k = 0; isSame && k < expected.size(); k++) {
+      isSame = expected[k].door == motorCommands[k].door && expected[k].duty == motorCommands[k].duty
+        && (expected[k].duty == 0 || expected[k].isOpening == motorCommands[k].isOpening);
+    }
+    if (!isSame) {
+      mismatches++;
+      printf("%8lu ms  Motor commands differ: traced", passTime);
+      for (const MotorCommand& c : expected) {
+        printf(" [door %u %s %d]", c.door + 1, c.isOpening ? "open" : "close", c.duty);
+      }
+      printf(", replayed");
+      for (const MotorCommand& c : motorCommands) {
+        printf(" [door %u %s %d]", c.door + 1, c.isOpening ? "open" : "close", c.duty);
+      }
+      printf("\n");
+    }
+    else if (isVerbose) {
+      for (const MotorCommand& c : motorCommands) {
+        printf("%8lu ms  Door %u motor %s %d\n", passTime, c.door + 1, c.isOpening ? "open" : "close", c.duty);
+      }
+    }
+  }
+
+  printf("\n%zu records over %lu ms: %lu buttons, %lu stalls, %lu motor mismatches\n", records.size(),
+    records.empty() ? 0 : records.back().time - records.front().time, buttons, stalls, mismatches);
+  for (uint8_t t = 0; t < 2; t++) {
+    const TaskProfile& p = profiles[t];
+    printf("%s task: %lu runs, mean gap %lu ms, max gap %lu ms, %lu late\n", taskNames[t], p.runs,
+      p.gaps ? p.totalGap / p.gaps : 0, p.maxGap, p.late);
+  }
+  printf("Final screen:\n");
+  sim->printLcd();
+  return mismatches ? 1 : 0;
+}
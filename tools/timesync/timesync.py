@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Sets the feeder's clock from this PC's clock over Serial, to within a few ms (see TimeSync.h).
+
+Usage:
+  timesync.py --port /dev/ttyACM0 [--baud 9600] [--exchanges 10] [--utc-offset HOURS]
+  timesync.py --port /dev/ttyACM0 --status
+
+This PC stands in for the reference clock, so keep it synced (e.g. by NTP). The feeder's clock is local
+time: --utc-offset defaults to this PC's own offset.
+
+Run it every day or so (e.g. from cron): once the RTC has run undisturbed for 12 h between two syncs,
+the feeder trims its drift with the DS3231's aging offset, so it drifts less and less between syncs.
+Needs pyserial.
+"""
+import argparse
+import calendar
+import sys
+import time
+
+# 2000-01-01 00:00:00, the feeder's epoch, as a Unix time
+EPOCH_2000 = calendar.timegm((2000, 1, 1, 0, 0, 0))
+# How far ahead (s) of the last exchange the clock is set: over the 1.1 s the feeder needs to find its
+# RTC's second (TimeSync.cpp's minLead_ms), with room for the command to get there.
+SET_LEAD = 1.5
+
+
+def now_ms():
+    return time.time() * 1000.0
+
+
+class Feeder:
+    def __init__(self, port, baud):
+        import serial  # pyserial
+        # Opening the port resets the Uno, so wait for it to boot, then drop whatever it sent
+        self.port = serial.Serial(port, baud, timeout=5)
+        self.baud = baud
+        time.sleep(2.5)
+        self.port.reset_input_buffer()
+
+    def send(self, line):
+        self.port.write((line + "\n").encode())
+        self.port.flush()
+
+    def reply(self, prefixes):
+        """Reads lines until one starts with one of prefixes. Returns it, and when it arrived (ms)."""
+        while True:
+            raw = self.port.readline()
+            t = now_ms()
+            if not raw:
+                raise RuntimeError("no reply from the feeder")
+            line = raw.decode(errors="replace").strip()
+            if line.split(" ")[0] in prefixes:
+                return line, t
+
+    def wire_ms(self, n):
+        """How long (ms) n bytes take on the wire (8N1: 10 bits a byte)."""
+        return n * 10000.0 / self.baud
+
+    def exchange(self):
+        """One timestamp exchange. Returns (the PC's time at its midpoint, the offset of millis() from
+        the PC's clock, the round trip), all in ms, with the time each line takes on the wire taken out
+        so the two directions are even."""
+        t1 = now_ms()
+        request = "s %d" % (int(t1) % 1000000000)
+        self.send(request)
+        line, t4 = self.reply(("S",))
+        _, echo, t2, t3 = line.split()
+        if echo != request[2:]:
+            raise RuntimeError("out of order reply: " + line)
+        t2, t3 = int(t2), int(t3)
+        up, down = self.wire_ms(len(request) + 1), self.wire_ms(len(line) + 2)
+        offset = ((t2 - (t1 + up)) + (t3 - (t4 - down))) / 2
+        delay = (t4 - t1) - (t3 - t2) - up - down
+        return (t1 + t4) / 2, offset, delay
+
+
+def fit(samples):
+    """Fits millis() = a + b * (PC time) to the exchanges with the shortest round trips, so neither a
+    slow exchange nor millis() running fast or slow throws off where the set lands."""
+    best = min(s[2] for s in samples)
+    good = [s for s in samples if s[2] <= best + 2]
+    x0 = good[0][0]
+    xs = [s[0] - x0 for s in good]
+    ys = [s[0] + s[1] - x0 for s in good]
+    n = len(good)
+    if n < 3:
+        return ys[0] - xs[0], 1.0, x0, good
+    sx, sy = sum(xs), sum(ys)
+    sxx, sxy = sum(x * x for x in xs), sum(x * y for x, y in zip(xs, ys))
+    b = (n * sxy - sx * sy) / (n * sxx - sx * sx)
+    a = (sy - b * sx) / n
+    return a, b, x0, good
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--port", required=True)
+    ap.add_argument("--baud", type=int, default=9600)
+    ap.add_argument("--exchanges", type=int, default=10)
+    ap.add_argument("--utc-offset", type=float, help="hours the feeder's time is ahead of UTC")
+    ap.add_argument("--status", action="store_true", help="only print the feeder's sync status")
+    args = ap.parse_args()
+    feeder = Feeder(args.port, args.baud)
+
+    if args.status:
+        feeder.send("s")
+        line, _ = feeder.reply(("A",))
+        _, aging, last, error = line.split()
+        print("aging offset %s, last sync %s, RTC was off by %s ms then" % (
+            aging, "none since boot" if last == "-1" else last, error))
+        return 0
+
+    if args.utc_offset is None:
+        utc_offset = -(time.altzone if time.localtime().tm_isdst > 0 else time.timezone)
+    else:
+        utc_offset = args.utc_offset * 3600
+    samples = []
+    for _ in range(args.exchanges):
+        samples.append(feeder.exchange())
+        time.sleep(0.25)
+    a, b, x0, good = fit(samples)
+    print("%d of %d exchanges used, round trip %.1f ms, millis() %+.0f ppm" % (
+        len(good), len(samples), min(s[2] for s in good), (b - 1) * 1e6))
+
+    # The first whole second far enough ahead, as the feeder's local time, and the millis() it starts at
+    local_ms = now_ms() + utc_offset * 1000
+    second = int((local_ms + SET_LEAD * 1000) // 1000) + 1
+    pc_ms = second * 1000.0 - utc_offset * 1000
+    at = int(round(x0 + a + b * (pc_ms - x0)))
+    feeder.send("s %d %d" % (at % 2**32, second - EPOCH_2000))
+    line, _ = feeder.reply(("OK", "ERR"))
+    if line == "OK":
+        line, _ = feeder.reply(("SYNC", "ERR"))
+    if line == "ERR":
+        print("the feeder couldn't set its clock", file=sys.stderr)
+        return 1
+    _, _, error, aging = line.split()
+    print("set to %s; the RTC was %s, aging offset %s" % (
+        time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(second)),
+        "off by an unknown amount" if error == "?" else "%+d ms off" % int(error), aging))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
\ No newline at end of file